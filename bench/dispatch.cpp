@@ -0,0 +1,38 @@
+//  Tokens per second through Manager with each dispatch backend: one
+//  global slot and two per-function slots, as a player would connect them.
+//    g++ -std=c++17 -O2 -I.. dispatch.cpp -o dispatch && ./dispatch [script files...]
+//  Without files a story of 400k lines is made up.
+
+#include <iostream>
+
+#include "../lexer.hpp"
+#include "../manager.hpp"
+#include "story.hpp"
+
+namespace {
+	template<typename Dispatch>
+	void run(const char* name, const std::string& text) {
+		arksp::BasicManager<Dispatch> manager;
+		manager.init(arksp::Lexer::lex(text));
+		std::size_t sum = 0;  //  so the slots aren't optimized away
+		manager.connect([&sum](ARKSP_SIGNAL_VIEW(tok)) { sum += tok.text.size(); });
+		manager.connect("character", [&sum](ARKSP_SIGNAL_VIEW(tok)) { sum += tok.propCount; });
+		manager.connect("name", [&sum](ARKSP_SIGNAL_VIEW()) { sum += 1; });
+
+		const double ms = arksp::bench::bestOf(5, [&] {
+			manager.ptrRewind();
+			do {
+				manager.emitSignal();
+			} while (manager.ptrForward());
+		});
+		const double tokens = static_cast<double>(manager.getSize());
+		std::cout << name << ' ' << tokens / ms / 1000 << " M tokens/s (" << ms << " ms, " << sum << ")\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::string text = arksp::bench::loadStory(argc, argv, 400000);
+	run<arksp::SignalsDispatch>("SignalsDispatch", text);
+	run<arksp::DirectDispatch>("DirectDispatch ", text);
+	return 0;
+}
@@ -0,0 +1,66 @@
+//  Tokens per second through Environment::slotRead() over a whole chapter,
+//  and through slotReadView() and the handlers of setHandler().
+//    g++ -std=c++17 -O2 -I.. environment.cpp -o environment && ./environment [script files...]
+//  Without files a story of 50k lines is made up. For the numbers before
+//  a change, copy bench/ into a checkout of the older tree and build it
+//  there with -DARKSP_BENCH_SLOTREAD_ONLY if that videocore.hpp has only
+//  slotRead(), then compare the first line.
+
+#include <iostream>
+#include <vector>
+
+#include "../lexer.hpp"
+#include "../videocore.hpp"
+#include "story.hpp"
+
+namespace {
+	void report(const char* name, const double& ms, const std::size_t& tokens) {
+		std::cout << name << ' ' << static_cast<double>(tokens) / ms / 1000 << " M tokens/s (" << ms << " ms)\n";
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::string text = arksp::bench::loadStory(argc, argv, 50000);
+	const std::vector<arksp::token> vecToken = arksp::Lexer::lexer(text);
+	std::cout << vecToken.size() << " tokens\n";
+
+	double ms = arksp::bench::bestOf(25, [&] {
+		arksp::Environment env;
+		for (auto& s : vecToken) {
+			env.slotRead(std::get<arksp::Func>(s), std::get<arksp::Text>(s), std::get<arksp::Prop>(s));
+		}
+	});
+	report("slotRead()                ", ms, vecToken.size());
+
+#ifndef ARKSP_BENCH_SLOTREAD_ONLY
+	const arksp::Script script = arksp::Lexer::lex(text);
+	std::size_t states = 0;
+	ms = arksp::bench::bestOf(25, [&] {
+		arksp::Environment env;
+		for (auto& tok : script) {
+			env.slotReadView(tok);
+		}
+		states = env.getStateCount();
+	});
+	report("slotReadView()            ", ms, script.size());
+
+	//  Commands the library doesn't know: half have a handler, half go
+	//  through the same single lookup and are skipped.
+	std::string custom;
+	for (int i = 0; i < 50000; ++i) {
+		custom += i % 2 == 0 ? "[fx_shake(strength=1)]\n" : "[fx_other(strength=1)]\n";
+	}
+	const arksp::Script customScript = arksp::Lexer::lex(custom);
+	std::size_t calls = 0;
+	ms = arksp::bench::bestOf(25, [&] {
+		arksp::Environment env;
+		env.setHandler("fx_shake", [&calls](arksp::Environment&, ARKSP_SIGNAL_VIEW(tok)) { calls += tok.propCount; });
+		for (auto& tok : customScript) {
+			env.slotReadView(tok);
+		}
+	});
+	report("slotReadView(), custom    ", ms, customScript.size());
+	std::cout << calls / 25 << " handler calls, " << states << " states\n";
+#endif
+	return 0;
+}
@@ -0,0 +1,67 @@
+//  scan::find_any against a plain loop, and the lexer on top of it.
+//  Build it once as is, once with -DARKSP_NO_SIMD and once with -mavx2 to
+//  compare the three paths of scan.hpp:
+//    g++ -std=c++17 -O2 -I.. scan.cpp -o scan && ./scan [script files...]
+//  Without files a story of 400k lines is made up.
+
+#include <iostream>
+
+#include "../lexer.hpp"
+#include "story.hpp"
+
+namespace {
+	template<char... Cs>
+	const char* plainFind(const char* b, const char* e) {
+		for (; b < e; ++b) {
+			if (((*b == Cs) || ...)) {
+				return b;
+			}
+		}
+		return e;
+	}
+
+	//  how many characters find finds in text
+	std::size_t count(const std::string& text, const char* (*find)(const char*, const char*)) {
+		std::size_t ret = 0;
+		const char* const e = text.data() + text.size();
+		for (const char* p = find(text.data(), e); p != e; p = find(p + 1, e)) {
+			++ret;
+		}
+		return ret;
+	}
+}
+
+int main(int argc, char** argv) {
+	const std::string text = arksp::bench::loadStory(argc, argv, 400000);
+	const double mb = static_cast<double>(text.size()) / 1e6;
+#if defined(ARKSP_SCAN_AVX2)
+	std::cout << "scan.hpp: AVX2\n";
+#elif defined(ARKSP_SCAN_SSE2)
+	std::cout << "scan.hpp: SSE2\n";
+#else
+	std::cout << "scan.hpp: plain loops\n";
+#endif
+	std::cout << mb << " MB\n";
+
+	auto report = [mb](const char* name, const double& ms, const std::size_t& n) {
+		std::cout << name << ' ' << ms << " ms, " << mb / ms * 1000 << " MB/s (" << n << ")\n";
+	};
+	std::size_t n = 0;
+	double ms = arksp::bench::bestOf(5, [&] { n = count(text, plainFind<'\n'>); });
+	report("plain    '\\n'     ", ms, n);
+	ms = arksp::bench::bestOf(5, [&] { n = count(text, arksp::scan::find_any<'\n'>); });
+	report("find_any '\\n'     ", ms, n);
+	ms = arksp::bench::bestOf(5, [&] { n = count(text, plainFind<'[', ']', '(', ')'>); });
+	report("plain    brackets ", ms, n);
+	ms = arksp::bench::bestOf(5, [&] { n = count(text, arksp::scan::find_any<'[', ']', '(', ')'>); });
+	report("find_any brackets ", ms, n);
+
+	ms = arksp::bench::bestOf(5, [&] {
+		std::string copy = text;
+		n = arksp::Lexer::lex(std::move(copy)).size();
+	});
+	report("Lexer::lex()      ", ms, n);
+	ms = arksp::bench::bestOf(5, [&] { n = arksp::Lexer::lexer(text).size(); });
+	report("Lexer::lexer()    ", ms, n);
+	return 0;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+//  Input for the benchmarks: the script files given on the command line,
+//  concatenated, or a made up story of about the same mix of lines as the
+//  game's, the same for every run.
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+
+namespace arksp {
+	namespace bench {
+		inline std::string generateStory(const std::size_t& lines, const unsigned& seed = 1) {
+			static const char* const chars[] = { "char_002_amiya_1#1","char_010_chen_1#2","char_017_huang_1","avg_npc_003" };
+			static const char* const names[] = { "阿米娅","陈","Doctor" };
+			static const char* const sides[] = { "left","right" };
+			static const char* const times[] = { "1","0.5","2" };
+			std::mt19937 rng(seed);
+			auto pick = [&rng](const auto& arr) {
+				return arr[rng() % (sizeof(arr) / sizeof(arr[0]))];
+			};
+			auto between = [&rng](const int& lo, const int& hi) {
+				return std::to_string(lo + static_cast<int>(rng() % static_cast<unsigned>(hi - lo + 1)));
+			};
+			std::string ret = "[HEADER(key=\"title_test\", is_skippable=true, fit_mode=\"BLACK_MASK\")] \n[stopmusic]\n\n// comment line\n{\n}\n";
+			for (std::size_t i = 0; i < lines; ++i) {
+				const auto n = std::to_string(i);
+				const auto r = rng() % 100;
+				if (r < 25) {
+					ret += std::string("[name=\"") + pick(names) + "\"]  这是第" + n + "句台词，{@nickname}，你好 hello world.";
+				}
+				else if (r < 35) {
+					ret += std::string("[Character(name=\"") + pick(chars) + "\", name2=\"" + pick(chars) + "\",focus=2)]";
+				}
+				else if (r < 40) {
+					ret += std::string("[Character(name=\"") + pick(chars) + "\")]";
+				}
+				else if (r < 42) {
+					ret += "[Character]";
+				}
+				else if (r < 47) {
+					ret += std::string("[CharacterAction(name=\"") + pick(sides) + "\", type=\"move\", xpos=" + between(-50, 50) + ", ypos=" + between(-20, 20) + ", fadetime=1, block=true)]";
+				}
+				else if (r < 49) {
+					ret += "[CharacterAction(name=\"left\", type=\"exit\", direction=\"left\", fadetime=0.5)]";
+				}
+				else if (r < 53) {
+					ret += "[Background(image=\"bg_" + std::to_string(i % 7) + "\",screenadapt=\"coverall\", xscale=1.2, yscale=1.2, x=" + between(-100, 100) + ")]";
+				}
+				else if (r < 55) {
+					ret += "[BackgroundTween(xTo=" + between(-100, 100) + ", yTo=" + between(-100, 100) + ", duration=3, block=true)]";
+				}
+				else if (r < 58) {
+					ret += "[Image(image=\"img_" + n + "\", xScale=1, yScale=1, x=10, y=20, fadetime=1)]";
+				}
+				else if (r < 60) {
+					ret += "[ImageTween(xTo=5, yTo=6, xScaleTo=1.5, duration=2)]";
+				}
+				else if (r < 66) {
+					ret += std::string("[Delay(time=") + pick(times) + ")]";
+				}
+				else if (r < 69) {
+					ret += "[Decision(options=\"好;不好\", values=\"1;2\")]\n[Predicate(references=\"1\")]\n你选择了好\n"
+						"[Predicate(references=\"2\")]\n你选择了不好\n[Predicate(references=\"1;2\")]";
+				}
+				else if (r < 72) {
+					ret += "[PlayMusic(intro=\"$music_intro\", key=\"$music_loop\", volume=0.8)]";
+				}
+				else if (r < 75) {
+					ret += "[Blocker(a=1, r=0,g=0, b=0, fadetime=0, block=true)]";
+				}
+				else if (r < 78) {
+					ret += "[Dialog]";
+				}
+				else if (r < 80) {
+					ret += "[Subtitle(text=\"第" + n + "章\", x=100, y=200, alignment=\"center\", size=24, width=600)]";
+				}
+				else if (r < 82) {
+					//  an empty line
+				}
+				else if (r < 84) {
+					ret += "[PlaySound(key=\"$se_" + std::to_string(i % 3) + "\", volume=1, delay=0)]";
+				}
+				else if (r < 86) {
+					ret += "[CameraShake(duration=0.5, xstrength=10, ystrength=10, vibrato=30, randomness=90, fadeout=true, block=true)]";
+				}
+				else {
+					ret += "旁白文本 " + n + " ，{@nickname}走进了房间。";
+				}
+				ret += '\n';
+			}
+			return ret;
+		}
+
+		//  the files in argv[1..], or a story of lines lines if there are none
+		inline std::string loadStory(int argc, char** argv, const std::size_t& lines) {
+			if (argc < 2) {
+				return generateStory(lines);
+			}
+			std::string ret;
+			for (int i = 1; i < argc; ++i) {
+				std::ifstream ifs(argv[i], std::ios::binary);
+				if (!ifs) {
+					throw std::runtime_error(std::string("can't open ") + argv[i]);
+				}
+				ret.append(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+				if (!ret.empty() && ret.back() != '\n') {
+					ret += '\n';
+				}
+			}
+			return ret;
+		}
+
+		//  the fastest of runs calls of f, in milliseconds
+		inline double bestOf(const int& runs, const std::function<void()>& f) {
+			double ret = 0.0;
+			for (int i = 0; i < runs; ++i) {
+				auto t0 = std::chrono::steady_clock::now();
+				f();
+				auto t1 = std::chrono::steady_clock::now();
+				const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+				ret = i == 0 ? ms : std::min(ret, ms);
+			}
+			return ret;
+		}
+	}
+}
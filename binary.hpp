@@ -0,0 +1,388 @@
+#pragma once
+
+//  Precompiled scripts. Binary::save() writes a lexed Script as a string
+//  pool plus fixed-width tables of tokens, props and placeholders.
+//  Binary::load() maps the file into memory and builds the Script from the
+//  tables, every string of the Script points into the mapping and nothing
+//  is lexed or copied. The file has a version and the hash of the text it
+//  was lexed from, so a cache that doesn't match its text is detected.
+//  The file is in the byte order of the machine that wrote it, a file of
+//  the other byte order is rejected as if it had another version.
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <deque>
+#include <memory>
+#include <fstream>
+#include <cstring>
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "core.hpp"
+#include "symbol.hpp"
+#include "script.hpp"
+
+namespace arksp {
+	//  A read-only file mapped into memory, unmapped when destroyed.
+	class MappedFile {
+	public:
+		//  throws std::string if the file can't be opened or mapped
+		explicit MappedFile(const std::string& path) {
+#ifdef _WIN32
+			m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (m_file == INVALID_HANDLE_VALUE) {
+				throw std::string("Error: File " + path + " not exists");
+			}
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0) {
+				CloseHandle(m_file);
+				throw std::string("Error: File " + path + " is empty");
+			}
+			m_size = static_cast<std::size_t>(size.QuadPart);
+			m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (m_mapping == nullptr) {
+				CloseHandle(m_file);
+				throw std::string("Error: File " + path + " can't be mapped");
+			}
+			m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+			if (m_data == nullptr) {
+				CloseHandle(m_mapping);
+				CloseHandle(m_file);
+				throw std::string("Error: File " + path + " can't be mapped");
+			}
+#else
+			int fd = ::open(path.c_str(), O_RDONLY);
+			if (fd < 0) {
+				throw std::string("Error: File " + path + " not exists");
+			}
+			struct stat st;
+			if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+				::close(fd);
+				throw std::string("Error: File " + path + " is empty");
+			}
+			m_size = static_cast<std::size_t>(st.st_size);
+			void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			::close(fd);  //  the mapping stays valid
+			if (p == MAP_FAILED) {
+				throw std::string("Error: File " + path + " can't be mapped");
+			}
+			m_data = static_cast<const char*>(p);
+#endif
+		}
+		~MappedFile() {
+#ifdef _WIN32
+			UnmapViewOfFile(m_data);
+			CloseHandle(m_mapping);
+			CloseHandle(m_file);
+#else
+			::munmap(const_cast<char*>(m_data), m_size);
+#endif
+		}
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		const char* data() const {
+			return m_data;
+		}
+		std::size_t size() const {
+			return m_size;
+		}
+
+	private:
+		const char* m_data = nullptr;
+		std::size_t m_size = 0;
+#ifdef _WIN32
+		HANDLE m_file = INVALID_HANDLE_VALUE;
+		HANDLE m_mapping = nullptr;
+#endif
+	};
+
+	class Binary {
+	public:
+		static constexpr std::uint32_t Version = 1;
+
+		//  FNV-1a of the text, pass the text given to Lexer::lex()
+		static std::uint64_t hash(std::string_view source) {
+			std::uint64_t ret = 14695981039346656037ull;
+			for (auto c : source) {
+				ret ^= static_cast<unsigned char>(c);
+				ret *= 1099511628211ull;
+			}
+			return ret;
+		}
+
+		//  throws std::string if the file can't be written or the script is too large
+		static void save(const arksp::Script& script, const std::uint64_t& sourceHash, const std::string& path) {
+			std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+			if (!ofs) {
+				throw std::string("Error: File " + path + " can't be written");
+			}
+			save(script, sourceHash, ofs);
+			if (!ofs) {
+				throw std::string("Error: File " + path + " can't be written");
+			}
+		}
+		static void save(const arksp::Script& script, const std::uint64_t& sourceHash, std::ostream& os) {
+			Pool pool;
+			std::vector<TokenRecord> vecToken;
+			std::vector<PropRecord> vecProp;
+			std::vector<HolderRecord> vecHolder;
+			std::vector<NameRecord> vecFunc;
+			std::vector<NameRecord> vecKey;
+			vecToken.reserve(script.size());
+
+			for (auto& s : script) {
+				TokenRecord tok;
+				pool.add(s.func, tok.func, tok.funcSize);
+				pool.add(s.text, tok.text, tok.textSize);
+				tok.prop = static_cast<std::uint32_t>(vecProp.size());
+				tok.propCount = s.propCount;
+				tok.funcId = static_cast<std::uint16_t>(s.funcId);
+				for (auto ite = s.propBegin(); ite < s.propEnd(); ++ite) {
+					PropRecord prop;
+					pool.add(ite->key, prop.key, prop.keySize);
+					pool.add(ite->value, prop.value, prop.valueSize);
+					prop.keyId = static_cast<std::uint16_t>(ite->keyId);
+					vecProp.push_back(prop);
+				}
+				vecToken.push_back(tok);
+			}
+			for (auto& s : script.placeholders()) {
+				HolderRecord ph;
+				ph.token = s.token;
+				ph.prop = s.prop;
+				ph.begin = s.begin;
+				ph.end = s.end;
+				pool.add(s.key, ph.key, ph.keySize);
+				vecHolder.push_back(ph);
+			}
+			//  the names that aren't builtin, in the order of their IDs
+			auto& symbols = script.symbols();
+			for (auto i = static_cast<std::size_t>(arksp::Command::Count); i < symbols.funcs.size(); ++i) {
+				NameRecord name;
+				pool.add(symbols.funcs.name(static_cast<arksp::Command>(i)), name.name, name.size);
+				vecFunc.push_back(name);
+			}
+			for (auto i = static_cast<std::size_t>(arksp::PropKey::Count); i < symbols.keys.size(); ++i) {
+				NameRecord name;
+				pool.add(symbols.keys.name(static_cast<arksp::PropKey>(i)), name.name, name.size);
+				vecKey.push_back(name);
+			}
+
+			Header header;
+			std::memcpy(header.magic, Magic, sizeof(header.magic));
+			header.version = Version;
+			header.order = Order;
+			header.sourceHash = sourceHash;
+			header.tokenCount = static_cast<std::uint32_t>(vecToken.size());
+			header.propCount = static_cast<std::uint32_t>(vecProp.size());
+			header.holderCount = static_cast<std::uint32_t>(vecHolder.size());
+			header.funcCount = static_cast<std::uint32_t>(vecFunc.size());
+			header.keyCount = static_cast<std::uint32_t>(vecKey.size());
+			header.poolSize = pool.str.size();
+
+			os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			os.write(reinterpret_cast<const char*>(vecToken.data()), vecToken.size() * sizeof(TokenRecord));
+			os.write(reinterpret_cast<const char*>(vecProp.data()), vecProp.size() * sizeof(PropRecord));
+			os.write(reinterpret_cast<const char*>(vecHolder.data()), vecHolder.size() * sizeof(HolderRecord));
+			os.write(reinterpret_cast<const char*>(vecFunc.data()), vecFunc.size() * sizeof(NameRecord));
+			os.write(reinterpret_cast<const char*>(vecKey.data()), vecKey.size() * sizeof(NameRecord));
+			os.write(pool.str.data(), pool.str.size());
+		}
+
+		//  Throws std::string if the file isn't a precompiled script of this
+		//  version, or if sourceHash is given and doesn't match.
+		static arksp::Script load(const std::string& path) {
+			return load(std::make_shared<const arksp::MappedFile>(path), nullptr);
+		}
+		static arksp::Script load(const std::string& path, const std::uint64_t& sourceHash) {
+			return load(std::make_shared<const arksp::MappedFile>(path), &sourceHash);
+		}
+
+		//  whether path is a precompiled script of this version lexed from the
+		//  text of sourceHash, doesn't throw
+		static bool fresh(const std::string& path, const std::uint64_t& sourceHash) {
+			std::ifstream ifs(path, std::ios::binary);
+			Header header;
+			if (!ifs.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+				return false;
+			}
+			return check(header) == nullptr && header.sourceHash == sourceHash;
+		}
+
+	private:
+		static constexpr char Magic[8] = { 'A','R','K','S','P','B','I','N' };
+		static constexpr std::uint32_t Order = 0x01020304;  //  reads differently in the other byte order
+
+		struct Header {
+			char magic[8];
+			std::uint32_t version;
+			std::uint32_t order;
+			std::uint64_t sourceHash;
+			std::uint32_t tokenCount;
+			std::uint32_t propCount;
+			std::uint32_t holderCount;
+			std::uint32_t funcCount;
+			std::uint32_t keyCount;
+			std::uint32_t reserved = 0;
+			std::uint64_t poolSize;
+		};
+		//  strings are (offset into the pool, size)
+		struct TokenRecord {
+			std::uint32_t func, funcSize;
+			std::uint32_t text, textSize;
+			std::uint32_t prop, propCount;  //  props of the token are contiguous
+			std::uint16_t funcId;
+			std::uint16_t reserved = 0;
+		};
+		struct PropRecord {
+			std::uint32_t key, keySize;
+			std::uint32_t value, valueSize;
+			std::uint16_t keyId;
+			std::uint16_t reserved = 0;
+		};
+		struct HolderRecord {
+			std::uint32_t token, prop, begin, end;
+			std::uint32_t key, keySize;
+		};
+		struct NameRecord {
+			std::uint32_t name, size;
+		};
+		static_assert(sizeof(Header) == 56 && sizeof(TokenRecord) == 28 && sizeof(PropRecord) == 20 &&
+			sizeof(HolderRecord) == 24 && sizeof(NameRecord) == 8, "arksp: Binary records not packed");
+
+		//  every distinct string is stored once
+		struct Pool {
+			std::string str;
+			std::unordered_map<std::string_view, std::uint32_t> map;
+			std::deque<std::string> keep;  //  the keys of map
+
+			void add(std::string_view s, std::uint32_t& offset, std::uint32_t& size) {
+				if (str.size() + s.size() > 0xffffffffull) {
+					throw std::string("Error: Script too large for Binary");
+				}
+				size = static_cast<std::uint32_t>(s.size());
+				auto ite = map.find(s);
+				if (ite != map.end()) {
+					offset = ite->second;
+					return;
+				}
+				offset = static_cast<std::uint32_t>(str.size());
+				str.append(s.data(), s.size());
+				keep.emplace_back(s);
+				map.emplace(keep.back(), offset);
+			}
+		};
+
+		//  nullptr if header is fine
+		static const char* check(const Header& header) {
+			if (std::memcmp(header.magic, Magic, sizeof(header.magic)) != 0) {
+				return "Error: Not a precompiled script";
+			}
+			if (header.version != Version || header.order != Order) {
+				return "Error: Version of precompiled script not matched";
+			}
+			return nullptr;
+		}
+
+		static arksp::Script load(std::shared_ptr<const arksp::MappedFile> file, const std::uint64_t* sourceHash) {
+			if (file->size() < sizeof(Header)) {
+				throw std::string("Error: Not a precompiled script");
+			}
+			const char* const base = file->data();
+			Header header;
+			std::memcpy(&header, base, sizeof(header));
+			if (auto error = check(header)) {
+				throw std::string(error);
+			}
+			if (sourceHash != nullptr && header.sourceHash != *sourceHash) {
+				throw std::string("Error: Precompiled script is stale");
+			}
+			const std::uint64_t total = sizeof(Header) +
+				std::uint64_t(header.tokenCount) * sizeof(TokenRecord) +
+				std::uint64_t(header.propCount) * sizeof(PropRecord) +
+				std::uint64_t(header.holderCount) * sizeof(HolderRecord) +
+				(std::uint64_t(header.funcCount) + header.keyCount) * sizeof(NameRecord) +
+				header.poolSize;
+			if (total != file->size()) {
+				throw std::string("Error: Precompiled script is truncated");
+			}
+
+			//  every table is 4 byte aligned in the file, and mappings are page aligned
+			auto tokens = reinterpret_cast<const TokenRecord*>(base + sizeof(Header));
+			auto props = reinterpret_cast<const PropRecord*>(tokens + header.tokenCount);
+			auto holders = reinterpret_cast<const HolderRecord*>(props + header.propCount);
+			auto funcs = reinterpret_cast<const NameRecord*>(holders + header.holderCount);
+			auto keys = funcs + header.funcCount;
+			const std::string_view pool(reinterpret_cast<const char*>(keys + header.keyCount), static_cast<std::size_t>(header.poolSize));
+			auto str = [&pool](const std::uint32_t& offset, const std::uint32_t& size) {
+				if (std::uint64_t(offset) + size > pool.size()) {
+					throw std::string("Error: Precompiled script is broken");
+				}
+				return pool.substr(offset, size);
+			};
+
+			arksp::Script ret;
+			for (std::uint32_t i = 0; i < header.funcCount; ++i) {
+				ret.m_symbols.funcs.intern(str(funcs[i].name, funcs[i].size));
+			}
+			for (std::uint32_t i = 0; i < header.keyCount; ++i) {
+				ret.m_symbols.keys.intern(str(keys[i].name, keys[i].size));
+			}
+			ret.m_vecProp.resize(header.propCount);
+			for (std::uint32_t i = 0; i < header.propCount; ++i) {
+				auto& s = ret.m_vecProp[i];
+				s.key = str(props[i].key, props[i].keySize);
+				s.value = str(props[i].value, props[i].valueSize);
+				s.keyId = static_cast<arksp::PropKey>(props[i].keyId);
+			}
+			ret.m_vecToken.resize(header.tokenCount);
+			for (std::uint32_t i = 0; i < header.tokenCount; ++i) {
+				auto& s = ret.m_vecToken[i];
+				if (std::uint64_t(tokens[i].prop) + tokens[i].propCount > header.propCount) {
+					throw std::string("Error: Precompiled script is broken");
+				}
+				s.func = str(tokens[i].func, tokens[i].funcSize);
+				s.text = str(tokens[i].text, tokens[i].textSize);
+				s.props = ret.m_vecProp.data() + tokens[i].prop;
+				s.propCount = tokens[i].propCount;
+				s.funcId = static_cast<arksp::Command>(tokens[i].funcId);
+			}
+			ret.m_vecHolder.resize(header.holderCount);
+			for (std::uint32_t i = 0; i < header.holderCount; ++i) {
+				auto& s = ret.m_vecHolder[i];
+				if (holders[i].token >= header.tokenCount) {
+					throw std::string("Error: Precompiled script is broken");
+				}
+				auto& tok = ret.m_vecToken[holders[i].token];
+				if (holders[i].prop != arksp::placeholder::Text && holders[i].prop >= tok.propCount) {
+					throw std::string("Error: Precompiled script is broken");
+				}
+				auto target = holders[i].prop == arksp::placeholder::Text ? tok.text : tok.props[holders[i].prop].value;
+				if (holders[i].begin > holders[i].end || holders[i].end > target.size()) {
+					throw std::string("Error: Precompiled script is broken");
+				}
+				s.token = holders[i].token;
+				s.prop = holders[i].prop;
+				s.begin = holders[i].begin;
+				s.end = holders[i].end;
+				s.key = str(holders[i].key, holders[i].keySize);
+			}
+			ret.m_keep = std::move(file);
+			return ret;
+		}
+	};
+}
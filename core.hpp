@@ -1,12 +1,18 @@
 #pragma once
 
 //  To use ArknightsScriptParser and it's derived libraries, 
-//  the compiler must support C++14. And it's recommended to 
-//  use C++17, in order to avoid some unnecessary work.
+//  the compiler must support C++17, token_view and Script are 
+//  built on std::string_view.
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <optional>
+#include <tuple>
 #include <utility>
+#include <cstdint>
+
+#include "symbol.hpp"
 
 #define ARKSP_EASY_READALL(_Str, _Ifs) \
 	_Str.assign(std::istreambuf_iterator<char>( _Ifs ), \
@@ -20,4 +26,67 @@ namespace arksp {
 		Text = 2
 	};
 	typedef std::tuple<std::string, std::vector<std::pair<std::string, std::string>>, std::string> token;
+
+	//  token_view and prop_view don't own anything, they point into the 
+	//  buffer of the arksp::Script they come from.
+	//  funcId and keyId are interned by the lexer, see symbol.hpp
+	struct prop_view {
+		std::string_view key;
+		std::string_view value;
+		arksp::PropKey keyId = arksp::PropKey::Unknown;
+	};
+
+	struct token_view {
+		std::string_view func;
+		const prop_view* props = nullptr;
+		std::uint32_t propCount = 0;
+		std::string_view text;
+		arksp::Command funcId = arksp::Command::Unknown;
+
+		const prop_view* propBegin() const {
+			return props;
+		}
+		const prop_view* propEnd() const {
+			return props + propCount;
+		}
+
+		//  The first prop with keyId, nullptr if there is none. Keys are
+		//  interned when they are lexed, so this compares integers and
+		//  allocates nothing. A token has a few props, scanning them is
+		//  faster than keeping them sorted.
+		const prop_view* findProp(const arksp::PropKey& keyId) const {
+			for (auto ite = propBegin(); ite < propEnd(); ++ite) {
+				if (ite->keyId == keyId) {
+					return ite;
+				}
+			}
+			return nullptr;
+		}
+		std::optional<std::string_view> valueOf(const arksp::PropKey& keyId) const {
+			auto p = findProp(keyId);
+			return p != nullptr ? std::optional<std::string_view>(p->value) : std::nullopt;
+		}
+
+		//  materialize into the owning tuple, for existing callers
+		arksp::token toToken() const {
+			std::vector<std::pair<std::string, std::string>> vecProp;
+			vecProp.reserve(propCount);
+			for (auto ite = propBegin(); ite < propEnd(); ++ite) {
+				vecProp.push_back({ std::string(ite->key),std::string(ite->value) });
+			}
+			return arksp::token{ std::string(func),std::move(vecProp),std::string(text) };
+		}
+	};
+
+	//  Where a placeholder is: {@key} in the text of a token, or a prop value
+	//  $key. begin and end are offsets into the text or the value.
+	struct placeholder {
+		static constexpr std::uint32_t Text = 0xffffffff;
+
+		std::uint32_t token = 0;
+		std::uint32_t prop = Text;  //  index into the props of the token, or Text
+		std::uint32_t begin = 0;
+		std::uint32_t end = 0;
+		std::string_view key;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,338 @@
+#pragma once
+
+//  Lexes many scripts at once. Every script is a task of a work stealing
+//  pool, and an error only fails its own script.
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <numeric>
+#include <algorithm>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <string_view>
+
+#include "core.hpp"
+#include "lexer.hpp"
+#include "script.hpp"
+#include "symbol.hpp"
+#include "scan.hpp"
+
+namespace arksp {
+	//  Runs a batch of tasks on a number of threads. Each thread has its own
+	//  deque of tasks and takes its next task from the front of it. When it
+	//  runs out it steals from the back of the others, so a few long tasks
+	//  don't leave the other threads idle. The calling thread is one of them.
+	class TaskPool {
+	public:
+		//  0 is std::thread::hardware_concurrency()
+		explicit TaskPool(const unsigned int& threads = 0)
+			: m_threads(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency())) {}
+
+		unsigned int threads() const {
+			return m_threads;
+		}
+
+		//  Calls task(i) for every i in order, the front of order is given out first.
+		//  Returns when all of them are done. If a task throws, the first
+		//  exception is thrown again here after the others are done.
+		template<typename F>
+		void run(const std::vector<std::size_t>& order, F&& task) {
+			const unsigned int n = static_cast<unsigned int>(std::min<std::size_t>(m_threads, order.size()));
+			if (n == 0) {
+				return;
+			}
+			std::vector<Queue> queues(n);
+			//  round robin, so each thread starts with the front of the order
+			for (std::size_t i = 0; i < order.size(); ++i) {
+				queues[i % n].tasks.push_back(order[i]);
+			}
+
+			std::exception_ptr error;
+			std::mutex errorMutex;
+			auto work = [&](const unsigned int& self) {
+				std::size_t i;
+				while (take(queues, self, i)) {
+					try {
+						task(i);
+					}
+					catch (...) {
+						std::lock_guard<std::mutex> lock(errorMutex);
+						if (!error) {
+							error = std::current_exception();
+						}
+					}
+				}
+			};
+
+			std::vector<std::thread> vecThread;
+			vecThread.reserve(n - 1);
+			for (unsigned int i = 1; i < n; ++i) {
+				vecThread.emplace_back(work, i);
+			}
+			work(0);
+			for (auto& s : vecThread) {
+				s.join();
+			}
+			if (error) {
+				std::rethrow_exception(error);
+			}
+		}
+		template<typename F>
+		void run(const std::size_t& count, F&& task) {
+			std::vector<std::size_t> order(count);
+			std::iota(order.begin(), order.end(), 0);
+			run(order, std::forward<F>(task));
+		}
+
+	private:
+		struct Queue {
+			std::mutex mutex;
+			std::deque<std::size_t> tasks;  //  the owner takes the front, thieves the back
+		};
+
+		//  no task is added after run() starts, so all queues empty means done
+		static bool take(std::vector<Queue>& queues, const unsigned int& self, std::size_t& task) {
+			{
+				auto& own = queues[self];
+				std::lock_guard<std::mutex> lock(own.mutex);
+				if (!own.tasks.empty()) {
+					task = own.tasks.front();
+					own.tasks.pop_front();
+					return true;
+				}
+			}
+			for (std::size_t i = 1; i < queues.size(); ++i) {
+				auto& other = queues[(self + i) % queues.size()];
+				std::lock_guard<std::mutex> lock(other.mutex);
+				if (!other.tasks.empty()) {
+					task = other.tasks.back();
+					other.tasks.pop_back();
+					return true;
+				}
+			}
+			return false;
+		}
+
+		unsigned int m_threads;
+	};
+
+	//  result of one script, error is empty if it's lexed
+	struct CorpusEntry {
+		std::string name;  //  the path, or the index of the buffer
+		arksp::Script script;
+		std::string error;
+
+		bool ok() const {
+			return error.empty();
+		}
+	};
+
+	class Corpus {
+	public:
+		//  The results are in the order of paths, whatever order they are lexed in.
+		//  threads is 0 for std::thread::hardware_concurrency().
+		static std::vector<arksp::CorpusEntry> lexFiles(const std::vector<std::string>& paths, const unsigned int& threads = 0) {
+			std::vector<arksp::CorpusEntry> ret(paths.size());
+			std::vector<std::uint64_t> vecSize(paths.size(), 0);
+			for (std::size_t i = 0; i < paths.size(); ++i) {
+				ret[i].name = paths[i];
+				std::ifstream ifs(paths[i], std::ios::binary | std::ios::ate);
+				if (ifs) {
+					vecSize[i] = static_cast<std::uint64_t>(ifs.tellg());
+				}
+			}
+			arksp::TaskPool(threads).run(largestFirst(vecSize), [&ret](const std::size_t& i) {
+				std::ifstream ifs(ret[i].name, std::ios::binary);
+				if (!ifs) {
+					ret[i].error = "Error: File " + ret[i].name + " not exists";
+					return;
+				}
+				std::string text;
+				ARKSP_EASY_READALL(text, ifs);
+				lexOne(ret[i], std::move(text));
+			});
+			return ret;
+		}
+		static std::vector<arksp::CorpusEntry> lexBuffers(std::vector<std::string> buffers, const unsigned int& threads = 0) {
+			std::vector<arksp::CorpusEntry> ret(buffers.size());
+			std::vector<std::uint64_t> vecSize(buffers.size());
+			for (std::size_t i = 0; i < buffers.size(); ++i) {
+				ret[i].name = std::to_string(i);
+				vecSize[i] = buffers[i].size();
+			}
+			arksp::TaskPool(threads).run(largestFirst(vecSize), [&ret, &buffers](const std::size_t& i) {
+				lexOne(ret[i], std::move(buffers[i]));
+			});
+			return ret;
+		}
+
+		//  Lexer::lex() of one large text on several threads. The text is cut
+		//  into chunks of at least minChunk bytes at line breaks, every line is
+		//  lexed on its own anyway. The result, the IDs of the names and the
+		//  line number in an error are the same as Lexer::lex().
+		static arksp::Script lexParallel(std::string text, const unsigned int& threads = 0, const std::size_t& minChunk = 256 * 1024) {
+			if (text.empty()) {
+				throw std::string("Error: Empty Text");
+				return arksp::Script();
+			}
+			arksp::TaskPool pool(threads);
+			std::size_t n = std::min<std::size_t>(pool.threads() * 4, text.size() / std::max<std::size_t>(minChunk, 1));
+			if (n <= 1) {
+				return arksp::Lexer::lex(std::move(text));
+			}
+
+			arksp::Script ret;
+			ret.m_source = std::make_unique<std::string>(std::move(text));
+			const std::string_view source(*ret.m_source);
+
+			//  A chunk ends before a run of line breaks and the next one starts
+			//  after it, the same place LineCursor goes on from. Only the last
+			//  chunk has the line breaks at the end of the text.
+			std::vector<Chunk> vecChunk;
+			std::string_view::size_type start = 0;
+			for (std::size_t i = 1; i < n; ++i) {
+				auto eol = scan::find_any<'\n'>(source, std::max(start, source.size() / n * i));
+				if (eol == std::string_view::npos) {
+					break;
+				}
+				auto next = source.find_first_not_of('\n', eol);
+				if (next == std::string_view::npos) {
+					break;
+				}
+				while (eol > start && source[eol - 1] == '\n') {  //  from the start of the run
+					--eol;
+				}
+				vecChunk.emplace_back();
+				vecChunk.back().text = source.substr(start, eol - start);
+				start = next;
+			}
+			vecChunk.emplace_back();
+			vecChunk.back().text = source.substr(start);
+
+			pool.run(vecChunk.size(), [&vecChunk](const std::size_t& i) {
+				lexChunk(vecChunk[i]);
+			});
+
+			//  the first error in the text, with its line number in the whole text
+			int iCount = 0;
+			for (auto& s : vecChunk) {
+				if (s.failed) {
+					Lexer::LineParts parts;
+					Lexer::scan_line(s.badLine, iCount + s.lines + 1, parts);  //  throws the same error again
+				}
+				iCount += s.lines;
+			}
+
+			//  names that aren't builtin are interned in the order of the text
+			std::size_t nToken = 0;
+			std::size_t nProp = 0;
+			std::size_t nHolder = 0;
+			for (auto& s : vecChunk) {
+				nToken += s.tokens.size();
+				nProp += s.props.size();
+				nHolder += s.holders.size();
+			}
+			ret.m_vecToken.reserve(nToken);
+			ret.m_vecProp.reserve(nProp);
+			ret.m_vecHolder.reserve(nHolder);
+			for (auto& s : vecChunk) {
+				std::vector<arksp::Command> vecFunc;
+				for (auto i = static_cast<std::size_t>(arksp::Command::Count); i < s.symbols.funcs.size(); ++i) {
+					vecFunc.push_back(ret.m_symbols.funcs.intern(s.symbols.funcs.name(static_cast<arksp::Command>(i))));
+				}
+				std::vector<arksp::PropKey> vecKey;
+				for (auto i = static_cast<std::size_t>(arksp::PropKey::Count); i < s.symbols.keys.size(); ++i) {
+					vecKey.push_back(ret.m_symbols.keys.intern(s.symbols.keys.name(static_cast<arksp::PropKey>(i))));
+				}
+				const auto tokenBase = static_cast<std::uint32_t>(ret.m_vecToken.size());
+				for (auto tok : s.tokens) {
+					if (tok.funcId >= arksp::Command::Count) {
+						tok.funcId = vecFunc[static_cast<std::size_t>(tok.funcId) - static_cast<std::size_t>(arksp::Command::Count)];
+					}
+					ret.m_vecToken.push_back(tok);
+				}
+				for (auto prop : s.props) {
+					if (prop.keyId >= arksp::PropKey::Count) {
+						prop.keyId = vecKey[static_cast<std::size_t>(prop.keyId) - static_cast<std::size_t>(arksp::PropKey::Count)];
+					}
+					ret.m_vecProp.push_back(prop);
+				}
+				for (auto ph : s.holders) {
+					ph.token += tokenBase;
+					ret.m_vecHolder.push_back(ph);
+				}
+			}
+
+			//  props of each token are contiguous in m_vecProp
+			const arksp::prop_view* p = ret.m_vecProp.data();
+			for (auto& s : ret.m_vecToken) {
+				s.props = p;
+				p += s.propCount;
+			}
+			return ret;
+		}
+
+	private:
+		//  a part of the text of lexParallel(), lexed on its own
+		struct Chunk {
+			std::string_view text;
+			std::vector<arksp::token_view> tokens;  //  props not set
+			std::vector<arksp::prop_view> props;
+			std::vector<arksp::placeholder> holders;
+			arksp::Symbols symbols;
+			int lines = 0;
+			bool failed = false;
+			std::string_view badLine;
+		};
+
+		static void lexChunk(Chunk& chunk) {
+			arksp::LineCursor cursor(chunk.text);
+			Lexer::LineParts parts;
+			std::string_view s;
+			try {
+				while (cursor.next(s)) {
+					if (Lexer::scan_line(s, cursor.line(), parts)) {
+						auto tok = Lexer::view_line(parts, chunk.props, chunk.symbols);
+						arksp::Script::findPlaceholders(chunk.holders, chunk.tokens.size(), tok, chunk.props.data() + chunk.props.size() - tok.propCount);
+						chunk.tokens.push_back(tok);
+					}
+				}
+			}
+			catch (std::string&) {
+				//  lines before it in this chunk, the error is made again with the right number
+				chunk.failed = true;
+				chunk.badLine = s;
+				chunk.lines = cursor.line() - 1;
+				return;
+			}
+			chunk.lines = cursor.line();
+		}
+
+		static void lexOne(arksp::CorpusEntry& entry, std::string text) {
+			try {
+				entry.script = arksp::Lexer::lex(std::move(text));
+			}
+			catch (std::string& e) {
+				entry.error = e;
+			}
+			catch (std::exception& e) {
+				entry.error = e.what();
+			}
+		}
+
+		//  long scripts first, so that none of them is left to the end
+		static std::vector<std::size_t> largestFirst(const std::vector<std::uint64_t>& vecSize) {
+			std::vector<std::size_t> ret(vecSize.size());
+			std::iota(ret.begin(), ret.end(), 0);
+			std::stable_sort(ret.begin(), ret.end(), [&vecSize](const std::size_t& a, const std::size_t& b) {
+				return vecSize[a] > vecSize[b];
+			});
+			return ret;
+		}
+	};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+//  Dispatch backends of arksp::BasicManager (without ARKSP_QT).
+//  SignalsDispatch is boost::signals2, which is thread safe and is what
+//  arksp::Manager uses. DirectDispatch keeps plain std::function objects
+//  in a vector: no mutex, no connection tracking, no combiner. Use it
+//  when one thread drives the Manager, e.g. arksp::BasicManager<arksp::DirectDispatch>.
+
+#include <vector>
+#include <utility>
+#include <functional>
+#include <boost/signals2.hpp>
+
+#include "core.hpp"
+
+namespace arksp {
+	//  The part of the boost::signals2::signal interface Manager uses.
+	//  Slots are called in ascending order of group, and in the order they
+	//  were connected within a group. Unlike signals2, a slot must not connect
+	//  to or disconnect from the signal that is calling it.
+	template<typename Signature>
+	class DirectSignal {
+	public:
+		typedef std::function<Signature> SlotType;
+
+		void connect(const int& group, SlotType slot) {
+			auto ite = m_vecSlot.begin();
+			while (ite < m_vecSlot.end() && ite->first <= group) {
+				++ite;
+			}
+			m_vecSlot.insert(ite, { group,std::move(slot) });
+		}
+		void disconnect(const int& group) {
+			auto ite = m_vecSlot.begin();
+			while (ite < m_vecSlot.end()) {
+				if (ite->first == group) {
+					ite = m_vecSlot.erase(ite);
+				}
+				else {
+					++ite;
+				}
+			}
+		}
+		void disconnect_all_slots() {
+			m_vecSlot.clear();
+		}
+		bool empty() const {
+			return m_vecSlot.empty();
+		}
+
+		template<typename... Args>
+		void operator()(Args&&... args) const {
+			for (auto& s : m_vecSlot) {
+				s.second(args...);
+			}
+		}
+
+	private:
+		std::vector<std::pair<int, SlotType>> m_vecSlot;
+	};
+
+	struct SignalsDispatch {
+		typedef boost::signals2::signal<void(const arksp::token_view&)> SignalType;
+	};
+
+	struct DirectDispatch {
+		typedef arksp::DirectSignal<void(const arksp::token_view&)> SignalType;
+	};
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+//  For editors: keeps the text and the tokens of a script, and after an
+//  edit lexes only the lines around it again.
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+
+#include "core.hpp"
+#include "lexer.hpp"
+
+namespace arksp {
+	class Document {
+	public:
+		using sizeType = std::vector<arksp::token>::size_type;
+
+		//  The tokens [first, first + removed) before the edit are the tokens
+		//  [first, first + inserted) after it, the others are the same tokens.
+		//  Everything that depends on the tokens from first on needs to be redone.
+		struct Change {
+			sizeType first = 0;
+			sizeType removed = 0;
+			sizeType inserted = 0;
+
+			bool empty() const {
+				return removed == 0 && inserted == 0;
+			}
+		};
+
+		//  throws the same errors as Lexer::lexer()
+		explicit Document(std::string text) : m_text(std::move(text)) {
+			if (m_text.empty()) {
+				throw std::string("Error: Empty Text");
+			}
+			relex(0, m_text.size(), true, 0, m_lines, m_tokens);
+		}
+
+		//  Replaces the bytes [begin, end) of the text with replacement and
+		//  patches the tokens. If the new text has a syntax error, the error of
+		//  Lexer::lexer() is thrown and nothing is changed.
+		Change edit(const std::size_t& begin, const std::size_t& end, std::string_view replacement) {
+			if (begin > end || end > m_text.size()) {
+				throw std::string("Error: Out of index");
+			}
+			if (m_text.size() - (end - begin) + replacement.size() == 0) {
+				throw std::string("Error: Empty Text");
+			}
+			const std::string old = m_text.substr(begin, end - begin);
+			m_text.replace(begin, end - begin, replacement.data(), replacement.size());
+			const std::ptrdiff_t delta = static_cast<std::ptrdiff_t>(replacement.size()) - static_cast<std::ptrdiff_t>(end - begin);
+
+			//  the lines the edit touches, plus any line it merges into them
+			sizeType a = lineAt(begin);
+			sizeType b = lineAt(end);
+			std::size_t from, to;
+			bool last;
+			while (true) {
+				from = m_lines[a].begin;
+				last = b + 1 == m_lines.size();
+				to = last ? m_text.size() : static_cast<std::size_t>(static_cast<std::ptrdiff_t>(m_lines[b + 1].begin) + delta);
+				if (a > 0 && (from == m_text.size() || m_text[from] == '\n')) {
+					--a;  //  the line breaks before belong to the line before
+				}
+				else if (!last && (to == from || m_text[to - 1] != '\n')) {
+					++b;  //  the line break to the next line is gone
+				}
+				else {
+					break;
+				}
+			}
+
+			std::vector<Line> vecLine;
+			std::vector<arksp::token> vecToken;
+			try {
+				relex(from, to, last, static_cast<int>(a), vecLine, vecToken);
+			}
+			catch (...) {
+				m_text.replace(begin, replacement.size(), old);
+				throw;
+			}
+
+			Change ret;
+			for (sizeType i = 0; i < a; ++i) {
+				ret.first += m_lines[i].token;
+			}
+			for (sizeType i = a; i <= b; ++i) {
+				ret.removed += m_lines[i].token;
+			}
+			ret.inserted = vecToken.size();
+
+			//  the lines around the edit are often lexed to the same tokens again,
+			//  those are left as they are and not in the change
+			const auto oldBegin = m_tokens.begin() + ret.first;
+			sizeType head = 0;
+			while (head < ret.removed && head < ret.inserted && oldBegin[head] == vecToken[head]) {
+				++head;
+			}
+			sizeType tail = 0;
+			while (tail < ret.removed - head && tail < ret.inserted - head
+				&& oldBegin[ret.removed - 1 - tail] == vecToken[ret.inserted - 1 - tail]) {
+				++tail;
+			}
+			ret.first += head;
+			ret.removed -= head + tail;
+			ret.inserted -= head + tail;
+			const auto first = m_tokens.begin() + ret.first;
+			const auto common = std::min(ret.removed, ret.inserted);
+			std::move(vecToken.begin() + head, vecToken.begin() + head + common, first);
+			if (ret.removed > common) {
+				m_tokens.erase(first + common, first + ret.removed);
+			}
+			else {
+				m_tokens.insert(first + common, std::make_move_iterator(vecToken.begin() + head + common),
+					std::make_move_iterator(vecToken.begin() + head + ret.inserted));
+			}
+
+			m_lines.erase(m_lines.begin() + a, m_lines.begin() + b + 1);
+			m_lines.insert(m_lines.begin() + a, vecLine.begin(), vecLine.end());
+			for (auto i = a + vecLine.size(); i < m_lines.size(); ++i) {
+				m_lines[i].begin = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(m_lines[i].begin) + delta);
+			}
+			return ret;
+		}
+
+		const std::string& text() const {
+			return m_text;
+		}
+		//  the same as Lexer::lexer(text())
+		const std::vector<arksp::token>& tokens() const {
+			return m_tokens;
+		}
+		//  the number of lines as Lexer counts them
+		int lines() const {
+			return static_cast<int>(m_lines.size());
+		}
+
+	private:
+		//  a line as LineCursor gives it, with the line breaks after it
+		struct Line {
+			std::size_t begin;
+			bool token;  //  whether the line is a token or filtered out
+		};
+
+		//  the line the byte pos belongs to
+		sizeType lineAt(const std::size_t& pos) const {
+			auto ite = std::upper_bound(m_lines.begin(), m_lines.end(), pos, [](const std::size_t& p, const Line& line) {
+				return p < line.begin;
+			});
+			return ite == m_lines.begin() ? 0 : static_cast<sizeType>(ite - m_lines.begin() - 1);
+		}
+
+		//  Lexes the lines of m_text in [from, to). Unless last, [from, to) ends
+		//  with the line breaks before the next line, which aren't a line here.
+		void relex(const std::size_t& from, const std::size_t& to, const bool& last, const int& iCount,
+			std::vector<Line>& vecLine, std::vector<arksp::token>& vecToken) const {
+			std::string_view region = std::string_view(m_text).substr(from, to - from);
+			if (!last) {
+				while (!region.empty() && region.back() == '\n') {
+					region.remove_suffix(1);
+				}
+			}
+			arksp::LineCursor cursor(region);
+			Lexer::LineParts parts;
+			std::string_view s;
+			while (cursor.next(s)) {
+				Line line{ static_cast<std::size_t>(s.data() - m_text.data()),false };
+				if (Lexer::scan_line(s, iCount + cursor.line(), parts)) {
+					vecToken.push_back(Lexer::make_token(parts));
+					line.token = true;
+				}
+				vecLine.push_back(line);
+			}
+		}
+
+		std::string m_text;
+		std::vector<Line> m_lines;
+		std::vector<arksp::token> m_tokens;
+	};
+}
@@ -1,16 +1,87 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
-#include <boost/algorithm/string.hpp>
-
-#ifndef _MSC_VER
-#include <locale>
-#endif // _MSC_VER    clang thought that there is no std::tolower(char)
+#include <memory>
+#include <memory_resource>
+#include <algorithm>
 
 #include "core.hpp"
+#include "script.hpp"
+#include "scan.hpp"
 
 namespace arksp {
+	//  Walks a buffer once, line by line, without copying it. Empty lines
+	//  are merged into the previous line break, so line() counts the same
+	//  way as boost::split with token_compress_on did.
+	class LineCursor {
+	public:
+		LineCursor(std::string_view text) : m_text(text) {}
+
+		bool next(std::string_view& line) {
+			if (m_done) {
+				return false;
+			}
+			++m_iCount;
+			auto eol = scan::find_any<'\n'>(m_text, m_pos);
+			if (eol == std::string_view::npos) {
+				line = m_text.substr(m_pos);
+				m_done = true;
+				return true;
+			}
+			line = m_text.substr(m_pos, eol - m_pos);
+			m_pos = m_text.find_first_not_of('\n', eol);
+			if (m_pos == std::string_view::npos) {
+				m_pos = m_text.size();
+			}
+			return true;
+		}
+
+		int line() const {
+			return m_iCount;
+		}
+
+	private:
+		std::string_view m_text;
+		std::string_view::size_type m_pos = 0;
+		int m_iCount = 0;
+		bool m_done = false;
+	};
+
+	//  A syntax error of one line, see the overloads of Lexer that take a
+	//  vector of these.
+	struct Diagnostic {
+		enum class Kind {
+			EmptyText,
+			NoFunc,  //  "(" without "[" before it
+			OpenParenMissing,  //  ")" without "(" before it
+			CloseParenMissing,  //  "]" inside "(...)"
+			CloseBracketMissing  //  no "]" to the end of the line
+		};
+
+		int line = 0;  //  the same number as in the message lexer() throws
+		int column = 0;  //  of the character where the error is found, from 1, in bytes
+		Kind kind = Kind::EmptyText;
+		std::string source;  //  the line
+
+		//  what lexer() throws for the error
+		std::string message() const {
+			switch (kind) {
+			case Kind::EmptyText:
+				return "Error: Empty Text";
+			case Kind::NoFunc:
+				return "Line " + std::to_string(line) + " Syntax error: No Func\n" + source;
+			case Kind::OpenParenMissing:
+				return "Line " + std::to_string(line) + " Syntax error: Brackets not matched \"(\" missing\n" + source;
+			case Kind::CloseParenMissing:
+				return "Line " + std::to_string(line) + " Syntax error: Brackets not matched \")\" missing\n" + source;
+			default:
+				return "Line " + std::to_string(line) + " Syntax error: Brackets not matched \"]\" missing\n" + source;
+			}
+		}
+	};
+
 	class Lexer {
 	public:
 		~Lexer() = default;
@@ -21,151 +92,376 @@ namespace arksp {
 				return std::vector<arksp::token>();
 			}
 
-			std::vector<std::string> vecText;
-			boost::split(vecText, text, boost::is_any_of("\n"), boost::algorithm::token_compress_on);
-			if (vecText.empty()) {
-				throw std::string("Error: Empty Script");
-				return std::vector<arksp::token>();
+			std::vector<arksp::token> ret;
+			arksp::LineCursor cursor(text);
+			LineParts parts;
+			std::string_view s;
+			while (cursor.next(s)) {
+				if (scan_line(s, cursor.line(), parts)) {
+					ret.push_back(make_token(parts));
+				}
 			}
-
+			return ret;
+		}
+		//  Doesn't throw. A bad line is added to diagnostics and skipped, the
+		//  tokens of the other lines are the same as lexer() gives without it.
+		static std::vector<arksp::token> lexer(const std::string& text, std::vector<arksp::Diagnostic>& diagnostics) {
 			std::vector<arksp::token> ret;
-			int iCount = 0;
+			if (text.empty()) {
+				diagnostics.push_back(arksp::Diagnostic());
+				return ret;
+			}
+
+			arksp::LineCursor cursor(text);
+			LineParts parts;
+			std::string_view s;
+			arksp::Diagnostic::Kind kind;
+			std::string_view::size_type pos;
+			while (cursor.next(s)) {
+				switch (try_scan_line(s, parts, kind, pos)) {
+				case LineResult::Token:
+					ret.push_back(make_token(parts));
+					break;
+				case LineResult::Bad:
+					diagnostics.push_back(make_diagnostic(s, cursor.line(), kind, pos));
+					break;
+				default:
+					break;
+				}
+			}
+			return ret;
+		}
+
+		//  Zero-copy version of lexer(). The returned Script takes text over
+		//  and normalizes it in place, so every func, key, value and text of
+		//  the result is a view into one buffer instead of its own string.
+		//  Use Script::materialize() to get the same result as lexer().
+		//  The arrays of the Script and the scratch of lexing are allocated
+		//  from resource, with a std::pmr::monotonic_buffer_resource a whole
+		//  parse is freed at once by releasing it.
+		static arksp::Script lex(std::string text, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+			if (text.empty()) {
+				throw std::string("Error: Empty Text");
+				return arksp::Script();
+			}
+
+			arksp::Script ret(resource);
+			ret.m_source = std::make_unique<std::string>(std::move(text));
+
+			arksp::LineCursor cursor(*ret.m_source);
+			LineParts parts(resource);
+			std::string_view s;
+			while (cursor.next(s)) {
+				if (scan_line(s, cursor.line(), parts)) {
+					auto tok = view_line(parts, ret.m_vecProp, ret.m_symbols);
+					arksp::Script::findPlaceholders(ret.m_vecHolder, ret.m_vecToken.size(), tok, ret.m_vecProp.data() + ret.m_vecProp.size() - tok.propCount);
+					ret.m_vecToken.push_back(tok);
+				}
+			}
+
+			//  props of each token are contiguous in m_vecProp
+			const arksp::prop_view* p = ret.m_vecProp.data();
+			for (auto& s : ret.m_vecToken) {
+				s.props = p;
+				p += s.propCount;
+			}
+			return ret;
+		}
+		//  lex() that doesn't throw, as lexer() with diagnostics
+		static arksp::Script lex(std::string text, std::vector<arksp::Diagnostic>& diagnostics, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+			arksp::Script ret(resource);
+			if (text.empty()) {
+				diagnostics.push_back(arksp::Diagnostic());
+				return ret;
+			}
+			ret.m_source = std::make_unique<std::string>(std::move(text));
+
+			arksp::LineCursor cursor(*ret.m_source);
+			LineParts parts(resource);
+			std::string_view s;
+			arksp::Diagnostic::Kind kind;
+			std::string_view::size_type pos;
+			while (cursor.next(s)) {
+				switch (try_scan_line(s, parts, kind, pos)) {
+				case LineResult::Token: {
+					//  a bad line is never normalized, the Script keeps it as it was
+					auto tok = view_line(parts, ret.m_vecProp, ret.m_symbols);
+					arksp::Script::findPlaceholders(ret.m_vecHolder, ret.m_vecToken.size(), tok, ret.m_vecProp.data() + ret.m_vecProp.size() - tok.propCount);
+					ret.m_vecToken.push_back(tok);
+					break;
+				}
+				case LineResult::Bad:
+					diagnostics.push_back(make_diagnostic(s, cursor.line(), kind, pos));
+					break;
+				default:
+					break;
+				}
+			}
+
+			const arksp::prop_view* p = ret.m_vecProp.data();
+			for (auto& s : ret.m_vecToken) {
+				s.props = p;
+				p += s.propCount;
+			}
+			return ret;
+		}
+
+	private:
+		friend class TokenStream;
+		friend class Corpus;
+		friend class Document;
+
+		struct RawProp {
+			std::string_view key;
+			std::string_view value;
+			bool clean;  //  false for the value of [name="..."], which is kept as is
+		};
+		struct LineParts {
+			LineParts() {}
+			explicit LineParts(std::pmr::memory_resource* resource) : props(resource) {}
+
+			bool plain = false;
+			bool name = false;
+			std::string_view func;
+			std::pmr::vector<RawProp> props;
+			std::string_view text;
+		};
+
+		//  Returns false for the lines lexer() filters out, throws the error of a bad line.
+		static bool scan_line(std::string_view s, const int& iCount, LineParts& parts) {
+			arksp::Diagnostic::Kind kind;
+			std::string_view::size_type pos;
+			auto result = try_scan_line(s, parts, kind, pos);
+			if (result == LineResult::Bad) {
+				throw make_diagnostic(s, iCount, kind, pos).message();
+			}
+			return result == LineResult::Token;
+		}
+
+		static arksp::Diagnostic make_diagnostic(std::string_view s, const int& iCount, const arksp::Diagnostic::Kind& kind, const std::string_view::size_type& pos) {
+			arksp::Diagnostic ret;
+			ret.line = iCount;
+			ret.column = static_cast<int>(pos) + 1;
+			ret.kind = kind;
+			ret.source = std::string(s);
+			return ret;
+		}
+
+		enum class LineResult {
+			Filtered,
+			Token,
+			Bad  //  kind and pos tell what and where
+		};
+
+		//  The state machine of lexer(), but it only records where things are.
+		//  Never throws, a bad line is reported through the result.
+		static LineResult try_scan_line(std::string_view s, LineParts& parts, arksp::Diagnostic::Kind& kind, std::string_view::size_type& pos) {
+			if (s.empty() || s[0] == '{' || s[0] == '}' || s[0] == '/') {  //  filter useless statements
+				return LineResult::Filtered;
+			}
+			auto bad = [&kind, &pos](const arksp::Diagnostic::Kind& k, const std::string_view::size_type& p) {
+				kind = k;
+				pos = p;
+				return LineResult::Bad;
+			};
+			parts.props.clear();
+			parts.func = std::string_view();
+			parts.name = false;
+
+			if (s[0] != '[') {  //  PlainText
+				parts.plain = true;
+				parts.text = s;
+				return LineResult::Token;
+			}
+			parts.plain = false;
+
 			enum Statement
 			{
 				EMPTY,
 				FUNC,
 				PROP,
-				VALUE,
 				TEXT
 			};
-			for (auto s : vecText) {
-				++iCount;
-				if (s == "" || s[0] == '{' || s[0] == '}' || s[0] == '/') {  //  filter useless statements
-					continue;
-				}
-
-				if (s[0] != '[') {  //  PlainText
-					ret.push_back(make_token("PlainText", {}, clean_space(s)));
-					continue;
-				}
-
-				//  a simple state machine				
-				Statement state = Statement::EMPTY;
-				std::string term(""), strFunc("");
-				std::vector<std::pair<std::string, std::string>> vecProp;
-				for (auto c : s) {
-					if (state == Statement::TEXT) {
-						goto textappend;
-						//  sorry for using goto, but it is 1:02 am now, and i want to sleep
+			Statement state = Statement::EMPTY;
+			std::string_view::size_type term = 0;
+			//  only brackets change the state before TEXT, everything else is skipped in bulk
+			for (auto i = scan::find_any<'[', '(', ')', ']'>(s, 0);
+				i != std::string_view::npos && state != Statement::TEXT;
+				i = scan::find_any<'[', '(', ')', ']'>(s, i + 1)) {
+				switch (s[i]) {
+				case '[':
+					state = Statement::FUNC;
+					term = i + 1;
+					break;
+				case '(':
+					if (state != Statement::FUNC) {
+						return bad(arksp::Diagnostic::Kind::NoFunc, i);
 					}
-					if (c == '[') {
-						state = Statement::FUNC;
-						term = "";
-						continue;
+					state = Statement::PROP;
+					parts.func = s.substr(term, i - term);
+					parts.name = false;
+					term = i + 1;
+					break;
+				case ')': {
+					if (state != Statement::PROP) {
+						return bad(arksp::Diagnostic::Kind::OpenParenMissing, i);
 					}
-					if (c == '(') {
-						if (state != Statement::FUNC) {
-							throw std::string("Line " + std::to_string(iCount) + " Syntax error: No Func\n" + s);
-							return std::vector<arksp::token>();
+					//  split by "," and "=", an unpaired key at the end is dropped
+					auto list = s.substr(0, i);
+					std::string_view key;
+					bool hasKey = false;
+					for (auto b = term; ; ) {
+						auto e = scan::find_any<',', '='>(list, b);
+						if (e == std::string_view::npos) {
+							e = i;
 						}
-						else {
-							state = Statement::PROP;
-							strFunc = term;
-							term = "";
-							continue;
+						if (hasKey) {
+							parts.props.push_back({ key,s.substr(b, e - b),true });
 						}
-					}
-					if (c == ')') {
-						if (state != Statement::PROP) {
-							throw std::string("Line " + std::to_string(iCount) + " Syntax error: Brackets not matched \"(\" missing\n" + s);
-							return std::vector<arksp::token>();
-						}
-						std::vector<std::string> tempVec;
-						boost::split(tempVec, term, boost::is_any_of(",="), boost::algorithm::token_compress_off);
-						/*
-						if (tempVec.size() % 2 != 0) {
-							throw std::string("Line " + std::to_string(iCount) + " Syntax error: Prop and value not matched\n" + s);
-							return std::vector<arksp::token>();
-						}*/
-						for (auto& i : tempVec) {
-							if (i == "") {
-								i = "0";
-								continue;
-							}
-							for (auto& ch : i) {
-								if (ch == '\"') {
-									ch = 0;
-								}
-							}
-							i = clean_space(i);
+						else {
+							key = s.substr(b, e - b);
 						}
-						for (auto ite = tempVec.begin(); ite < tempVec.end(); ite += 2) {
-							vecProp.push_back({ *ite,*(ite + 1) });
+						hasKey = !hasKey;
+						if (e == i) {
+							break;
 						}
-						term = "";
-						state = Statement::EMPTY;
-						continue;
+						b = e + 1;
 					}
-					if (c == ']') {
-						if (state == Statement::FUNC) {
-							strFunc = term;
-							if (strstr(strFunc.c_str(), "name=") != NULL) {
-								vecProp.push_back({ "name",std::string(strFunc.begin() + 6,strFunc.end() - 1) });
-								strFunc = "name";
-							}
-							state = Statement::TEXT;
-							term = "";
-							continue;
-						}
-						if (state == Statement::PROP) {
-							throw std::string("Line " + std::to_string(iCount) + " Syntax error: Brackets not matched \")\" missing\n" + s);
-							return std::vector<arksp::token>();
+					state = Statement::EMPTY;
+					term = i + 1;
+					break;
+				}
+				case ']':
+					if (state == Statement::FUNC) {
+						parts.func = s.substr(term, i - term);
+						parts.name = parts.func.find("name=") != std::string_view::npos;
+						if (parts.name) {
+							auto size = parts.func.size();
+							parts.props.push_back({ "name",size > 6 ? parts.func.substr(6, size - 7) : std::string_view(),false });
 						}
-						state = Statement::TEXT;
-						term = "";
-						continue;
 					}
-					textappend:
-					term += c;
-				}
-				if (state != Statement::TEXT) {
-					throw std::string("Line " + std::to_string(iCount) + " Syntax error: Brackets not matched \"]\" missing\n" + s);
-					return std::vector<arksp::token>();
+					else if (state == Statement::PROP) {
+						return bad(arksp::Diagnostic::Kind::CloseParenMissing, i);
+					}
+					state = Statement::TEXT;
+					term = i + 1;
+					break;
+				default:
+					break;
 				}
-				ret.push_back(make_token(strFunc, vecProp, clean_space(term)));
-				term = "";
 			}
+			if (state != Statement::TEXT) {
+				return bad(arksp::Diagnostic::Kind::CloseBracketMissing, s.size());
+			}
+			parts.text = s.substr(term);
+			return LineResult::Token;
+		}
 
-#ifdef _MSC_VER
-			for (auto& s : ret) {
-				for (auto& i : std::get<arksp::TokenType::Func>(s)) {
-					i = std::tolower(i);
+		//  Normalizes the fields of a scanned line in place, interns the names
+		//  and appends its props to vecProp. The caller sets props of the result
+		//  once vecProp stops growing.
+		template<typename PropVec>
+		static arksp::token_view view_line(const LineParts& parts,
+			PropVec& vecProp,
+			arksp::Symbols& symbols) {
+			arksp::token_view tok;
+			tok.text = clean_space_inplace(parts.text);
+			if (parts.plain) {
+				tok.func = "plaintext";
+				tok.funcId = arksp::Command::PlainText;
+				return tok;
+			}
+			if (parts.name) {
+				tok.func = "name";
+				tok.funcId = arksp::Command::Name;
+			}
+			else {
+				tok.func = to_lower_inplace(parts.func);
+				tok.funcId = symbols.funcs.intern(tok.func);
+			}
+			for (auto& s : parts.props) {
+				if (!s.clean) {
+					vecProp.push_back({ s.key,s.value,symbols.keys.intern(s.key) });
+				}
+				else {
+					auto key = clean_value_inplace(s.key);
+					vecProp.push_back({ key,clean_value_inplace(s.value),symbols.keys.intern(key) });
 				}
 			}
-#else
-			std::locale locale;
-			for (auto& s : ret) {
-				for (auto& i : std::get<arksp::TokenType::Func>(s)) {
-					i = std::tolower(i, locale);
+			tok.propCount = static_cast<std::uint32_t>(parts.props.size());
+			return tok;
+		}
+
+		static inline arksp::token make_token(const LineParts& parts) {
+			if (parts.plain) {
+				return { "plaintext",{},clean_space(parts.text) };
+			}
+			std::vector<std::pair<std::string, std::string>> vecProp;
+			vecProp.reserve(parts.props.size());
+			for (auto& s : parts.props) {
+				if (!s.clean) {
+					vecProp.push_back({ std::string(s.key),std::string(s.value) });
+				}
+				else {
+					vecProp.push_back({ clean_value(s.key),clean_value(s.value) });
 				}
 			}
-#endif
-			return ret;
+			return { parts.name ? std::string("name") : to_lower(parts.func),std::move(vecProp),clean_space(parts.text) };
 		}
 
-	private:
-		static inline arksp::token make_token(const std::string& func,
-			const std::vector<std::pair<std::string, std::string>>& prop,
-			const std::string& text) {
-			return { func,prop,text };
-		}
-		static inline std::string clean_space(const std::string& str) {
-			std::string ret;
-			for (auto& c : str) {
+		//  The *_inplace helpers write through the view they are given. lex()
+		//  only passes views into the buffer owned by the Script being built,
+		//  the copying helpers pass their own string.
+		static inline std::string_view clean_space_inplace(std::string_view str) {
+			char* const b = const_cast<char*>(str.data());
+			char* out = b;
+			for (auto c : str) {
 				if (c != ' ' && c != '\0') {
-					ret += c;
+					*out++ = c;
 				}
 			}
+			return std::string_view(b, out - b);
+		}
+		static inline std::string_view clean_value_inplace(std::string_view str) {
+			if (str.empty()) {
+				return "0";
+			}
+			char* const b = const_cast<char*>(str.data());
+			char* out = b;
+			for (auto c : str) {
+				if (c != ' ' && c != '\0' && c != '\"') {
+					*out++ = c;
+				}
+			}
+			return std::string_view(b, out - b);
+		}
+		static inline std::string_view to_lower_inplace(std::string_view str) {
+			//  same as std::tolower with the classic locale
+			char* const b = const_cast<char*>(str.data());
+			for (std::string_view::size_type i = 0; i < str.size(); ++i) {
+				if (b[i] >= 'A' && b[i] <= 'Z') {
+					b[i] = b[i] - 'A' + 'a';
+				}
+			}
+			return str;
+		}
+
+		static inline std::string clean_space(std::string_view str) {
+			std::string ret(str);
+			ret.resize(clean_space_inplace(ret).size());
+			return ret;
+		}
+		static inline std::string clean_value(std::string_view str) {
+			if (str.empty()) {
+				return "0";
+			}
+			std::string ret(str);
+			ret.resize(clean_value_inplace(ret).size());
+			return ret;
+		}
+		static inline std::string to_lower(std::string_view str) {
+			std::string ret(str);
+			to_lower_inplace(ret);
 			return ret;
 		}
 
@@ -16,12 +16,16 @@
 #define ARKSP_QT
 #endif
 
+//  ARKSP_SIGNAL_VIEW is the recommended slot signature, the token is passed
+//  by reference and nothing is copied. Slots of ARKSP_SIGNAL_TYPE and
+//  ARKSP_SIGNAL_GLOBAL still work, but they get their own copy of the token.
 #ifndef ARKSP_QT
+#define ARKSP_SIGNAL_VIEW(_Token) const arksp::token_view& _Token
 #define ARKSP_SIGNAL_TYPE(_Text,_Prop) std::string _Text, std::vector<std::pair<std::string, std::string>> _Prop
 #define ARKSP_SIGNAL_GLOBAL(_Func_name, _Text, _Prop) std::string _Func_name, std::string _Text, \
 	std::vector<std::pair<std::string, std::string>> _Prop
-#include <boost/signals2.hpp>
 #include <functional>
+#include "dispatch.hpp"
 #else
 #include <qobject.h>
 #include <qstring.h>
@@ -32,10 +36,12 @@
 #include <utility>
 #include <string>
 #include <vector>
-#include <boost/property_tree/ptree.hpp>
-#include <boost/property_tree/json_parser.hpp>
-#include <sstream>
-#include <regex>
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <type_traits>
+#include <algorithm>
+#include <memory>
 
 #ifdef ARKSP_INVO
 #include "lexer.hpp"
@@ -43,43 +49,78 @@
 #endif
 
 #include "core.hpp"
+#include "symbol.hpp"
+#include "script.hpp"
+#include "stream.hpp"
+#include "placeholder.hpp"
 
 namespace arksp {
 #ifdef ARKSP_QT
 	class Manager : public QObject {
 		Q_OBJECT
-#else
-	class Manager {
-#endif
 	public:
 		Manager() {}
+#else
+	//  Dispatch is the backend of the signals, see dispatch.hpp.
+	//  arksp::Manager is BasicManager<arksp::SignalsDispatch>.
+	template<typename Dispatch = arksp::SignalsDispatch>
+	class BasicManager {
+	public:
+		BasicManager() {}
+		//  the tokens point into storage the Manager owns, a copy would point into
+		//  the original's, so only moving is allowed
+		BasicManager(const BasicManager&) = delete;
+		BasicManager& operator=(const BasicManager&) = delete;
+		BasicManager(BasicManager&&) = default;
+		BasicManager& operator=(BasicManager&&) = default;
+#endif
 
 		using sizeType = std::vector<arksp::token>::size_type;
 
 		bool init(const std::vector<arksp::token>& vecToken) {
-			m_vecToken.clear();
-			m_vecToken.shrink_to_fit();
-			m_iteToken = std::vector<arksp::token>::iterator();
+			return init(arksp::Script::fromTokens(vecToken));
+		}
+		bool init(std::vector<arksp::token>&& vecToken) {
+			return init(arksp::Script::fromTokens(std::move(vecToken)));
+		}
+		//  takes the result of Lexer::lex() over without copying it
+		bool init(arksp::Script&& script) {
+			return init(std::make_shared<const arksp::Script>(std::move(script)));
+		}
+		//  Any number of Managers can share one Script, each with its own pointer.
+		//  replace() and setNickname() don't change the Script, see m_mapPatch.
+		bool init(std::shared_ptr<const arksp::Script> script) {
+			m_script = emptyScript();
+			m_index = 0;
+			m_mapPoint.clear();
+			m_mapPatch.clear();
+			m_textVars = arksp::Variables();
+			m_propVars = arksp::Variables();
 #ifndef ARKSP_QT
-			m_vecSig.clear();
-			m_vecSig.shrink_to_fit();
+			m_mapSig.clear();
+			for (auto& s : m_arrSig) {
+				s.disconnect_all_slots();
+			}
 #endif
 
-			if (vecToken.empty()) {
+			if (script == nullptr || script->empty()) {
 				throw std::string("Error: Empty vecToken");
 				return false;
 			}
-			m_vecToken = vecToken;
-			m_iteToken = m_vecToken.begin();
+			m_script = std::move(script);
+			indexPoints();
 
 			return true;
 		}
 
 #ifdef ARKSP_INVO
 		Q_INVOKABLE bool init(QString path) {
-			m_vecToken.clear();
-			m_vecToken.shrink_to_fit();
-			m_iteToken = std::vector<arksp::token>::iterator();
+			m_script = emptyScript();
+			m_index = 0;
+			m_mapPoint.clear();
+			m_mapPatch.clear();
+			m_textVars = arksp::Variables();
+			m_propVars = arksp::Variables();
 
 			QFile file(path);
 			if (!file.exists()) {
@@ -89,8 +130,8 @@ namespace arksp {
 			file.open(QIODevice::ReadOnly);
 
 			try {
-				m_vecToken = arksp::Lexer::lexer(file.readAll().toStdString());
-				m_iteToken = m_vecToken.begin();
+				m_script = std::make_shared<const arksp::Script>(arksp::Lexer::lex(file.readAll().toStdString()));
+				indexPoints();
 			}
 			catch (std::exception& e) {
 				emit signalException(QString(e.what()));
@@ -106,26 +147,43 @@ namespace arksp {
 #endif
 
 #ifndef ARKSP_QT
+		//  Slots of ARKSP_SIGNAL_VIEW. Anything that can also be called with the
+		//  old arguments (e.g. boost::bind with placeholders) goes to the adapters below.
+		template<typename F, typename = std::enable_if_t<!std::is_invocable<F&, ARKSP_SIGNAL_TYPE(,)>::value>>
+		bool connect(const std::string& func_name,
+			F&& slot,
+			const int& group = 0) {
+			signalOf(func_name).connect(group, std::function<void(ARKSP_SIGNAL_VIEW())>(std::forward<F>(slot)));
+			return true;
+		}
+		template<typename F, typename = std::enable_if_t<!std::is_invocable<F&, ARKSP_SIGNAL_GLOBAL(,,)>::value>>
+		bool connect(F&& slot,
+			const int& group = 0) {
+			m_globalSig.connect(group, std::function<void(ARKSP_SIGNAL_VIEW())>(std::forward<F>(slot)));
+			return true;
+		}
+
+		//  adapters for the old signatures, the slot gets its own copy of the token
 		bool connect(const std::string& func_name,
-			const std::function<void(ARKSP_SIGNAL_TYPE())>& slot,
+			const std::function<void(ARKSP_SIGNAL_TYPE(,))>& slot,
 			const int& group = 0) {
-			at<std::string, SignalType>(func_name, m_vecSig).connect(group, slot);
+			signalOf(func_name).connect(group, adapt(slot));
 			return true;
 		}
 		bool connect(const std::string& func_name,
-			std::function<void(ARKSP_SIGNAL_TYPE())>&& slot,
+			std::function<void(ARKSP_SIGNAL_TYPE(,))>&& slot,
 			const int& group = 0) {
-			at<std::string, SignalType>(func_name, m_vecSig).connect(group, slot);
+			signalOf(func_name).connect(group, adapt(std::move(slot)));
 			return true;
 		}
-		bool connect(const std::function<void(ARKSP_SIGNAL_GLOBAL())>& slot,
+		bool connect(const std::function<void(ARKSP_SIGNAL_GLOBAL(,,))>& slot,
 			const int& group = 0) {
-			m_globalSig.connect(group, slot);
+			m_globalSig.connect(group, adapt(slot));
 			return true;
 		}
-		bool connect(std::function<void(ARKSP_SIGNAL_GLOBAL())>&& slot,
+		bool connect(std::function<void(ARKSP_SIGNAL_GLOBAL(,,))>&& slot,
 			const int& group = 0) {
-			m_globalSig.connect(group, slot);
+			m_globalSig.connect(group, adapt(std::move(slot)));
 			return true;
 		}
 		bool disconnect(const int& group) {
@@ -133,10 +191,14 @@ namespace arksp {
 			return true;
 		}
 		bool disconnect(const std::string& func_name, const int& group) {
-			for (auto ite = m_vecSig.begin(); ite < m_vecSig.end(); ++ite) {
-				if (ite->first == func_name) {
-					ite->second.disconnect(group);
-				}
+			auto cmd = arksp::commandOf(func_name);
+			if (cmd != arksp::Command::Unknown) {
+				m_arrSig[static_cast<std::size_t>(cmd)].disconnect(group);
+				return true;
+			}
+			auto ite = m_mapSig.find(func_name);
+			if (ite != m_mapSig.end()) {
+				ite->second.disconnect(group);
 			}
 			return true;
 		}
@@ -147,10 +209,10 @@ namespace arksp {
 #else
 		bool ptrForward(const unsigned int& step = 1) {
 #endif
-			if (m_iteToken + step >= m_vecToken.end()) {  //  no need for exception
+			if (m_index + step >= m_script->size()) {  //  no need for exception
 				return false;
 			}
-			m_iteToken += step;
+			m_index += step;
 			return true;
 		}
 
@@ -159,10 +221,10 @@ namespace arksp {
 #else
 		bool ptrBackward(const unsigned int& step = 1) {
 #endif		
-			if (m_iteToken - step < m_vecToken.begin()) {  //  no need for exception
+			if (step > m_index) {  //  no need for exception
 				return false;
 			}
-			m_iteToken -= step;
+			m_index -= step;
 			return true;
 		}
 
@@ -172,14 +234,19 @@ namespace arksp {
 #else
 		bool ptrMoveToPoint(const std::string & choice) {
 #endif		
-			for (arksp::Manager::sizeType s = m_iteToken - m_vecToken.begin(); s < m_vecToken.size(); ++s) {
-				if (std::get<arksp::Func>(m_vecToken[s]) == "predicate" &&
-					getValueByPropName("references", std::get<arksp::Prop>(m_vecToken[s])) == choice) {
-					m_iteToken = m_vecToken.begin() + s;
-					return true;
-				}
+			if (m_pointDirty) {
+				indexPoints();
+			}
+			auto ite = m_mapPoint.find(choice);
+			if (ite == m_mapPoint.end()) {
+				return false;
+			}
+			auto pos = std::lower_bound(ite->second.begin(), ite->second.end(), m_index);
+			if (pos == ite->second.end()) {
+				return false;
 			}
-			return false;
+			m_index = *pos;
+			return true;
 		}
 
 #ifdef ARKSP_INVO
@@ -187,8 +254,8 @@ namespace arksp {
 #else
 		bool ptrGoto(const unsigned int& point) {
 #endif
-			if (point < m_vecToken.size() || point >= 0) {
-				m_iteToken = m_vecToken.begin() + point;
+			if (point < m_script->size()) {
+				m_index = point;
 				return true;
 			}
 			else {
@@ -206,7 +273,7 @@ namespace arksp {
 #else
 		bool ptrRewind() {
 #endif
-			m_iteToken = m_vecToken.begin();
+			m_index = 0;
 			return true;
 		}
 
@@ -215,7 +282,7 @@ namespace arksp {
 #else
 		bool ptrFastForward() {
 #endif
-			if (m_vecToken.empty()) {
+			if (m_script->empty()) {
 #ifdef ARKSP_INVO
 				emit signalException("Error: Empty vecToken");
 #else
@@ -223,19 +290,24 @@ namespace arksp {
 #endif
 				return false;
 			}
-			m_iteToken = m_vecToken.end() - 1;
+			m_index = m_script->size() - 1;
 			return true;
 		}
 
 		arksp::token getToken(void) {
-			return *m_iteToken;
+			return readAt(m_index, m_readScratch).toToken();
+		}
+		//  Valid as long as the Manager isn't initialized again. With a context,
+		//  valid until the next getToken(), getTokenView() or operator[].
+		const arksp::token_view& getTokenView(void) {
+			return readAt(m_index, m_readScratch);
 		}
 #ifdef ARKSP_INVO
 		Q_INVOKABLE unsigned int getIndex(void) {
 #else
 		std::vector<arksp::token>::size_type getIndex(void) {
 #endif
-			return (m_iteToken - m_vecToken.begin());
+			return m_index;
 		}
 
 
@@ -244,22 +316,18 @@ namespace arksp {
 #else
 		auto getSize() {
 #endif		
-			return m_vecToken.size();
+			return m_script->size();
 		}
 
 #ifdef ARKSP_INVO
 		Q_INVOKABLE QString getFuncName() {
-			return QString::fromStdString(std::get<arksp::Func>(*m_iteToken));
+			return toQString(readAt(m_index, m_readScratch).func);
 		}
 		Q_INVOKABLE QVariantMap getPropMap() {
-			QVariantMap qvm;
-			for (auto s : std::get<arksp::Prop>(*m_iteToken)) {
-				qvm[QString::fromStdString(s.first)] = QString::fromStdString(s.second);
-			}
-			return qvm;
+			return toPropMap(readAt(m_index, m_readScratch));
 		}
 		Q_INVOKABLE QString getText() {
-			return QString::fromStdString(std::get<arksp::Text>(*m_iteToken));
+			return toQString(readAt(m_index, m_readScratch).text);
 		}
 #endif
 
@@ -269,32 +337,38 @@ namespace arksp {
 #else
 		bool replace(const std::string & json) {
 #endif
-			int index = 0;
+			std::string::size_type index = 0;
+			std::string error;
+			arksp::Variables vars;
 			try {
-				boost::property_tree::ptree root;
-				std::stringstream ss(json);
-				boost::property_tree::read_json(ss, root);
-
-				for (auto& s : m_vecToken) {
-					++index;
-					for (auto& i : std::get<arksp::Prop>(s)) {
-						if (i.second != "" && i.second[0] == '$') {
-							auto item = root.get_child(std::string(i.second.begin() + 1, i.second.end()));
-							i.second = item.data();
-						}
+				vars = arksp::Variables::fromJson(json);
+			}
+			catch (std::exception& e) {
+				error = e.what();
+			}
+			//  every $key needs a value, from this json or an earlier one
+			if (error.empty()) {
+				for (auto& s : m_script->placeholders()) {
+					if (s.prop != arksp::placeholder::Text &&
+						vars.find(s.key) == nullptr && m_propVars.find(s.key) == nullptr &&
+						(m_context == nullptr || m_context->find(s.key) == nullptr)) {
+						index = s.token + 1;
+						error = "No such node (" + std::string(s.key) + ")";
+						break;
 					}
 				}
-
-				return true;
 			}
-			catch (std::exception& e) {
+			if (!error.empty()) {
 #ifdef ARKSP_INVO
-				emit signalException("Line " + QString::number(index) + " Syntax error: Value invalid\nBoost: " + QString(e.what()));
+				emit signalException("Line " + QString::number(index) + " Syntax error: Value invalid\nBoost: " + QString::fromStdString(error));
 #else
-				throw std::string("Line " + std::to_string(index) + " Syntax error: Value invalid\nBoost: " + e.what());
+				throw std::string("Line " + std::to_string(index) + " Syntax error: Value invalid\nBoost: " + error);
 #endif
 				return false;
 			}
+			m_propVars.merge(vars);
+			refill(arksp::Variables(), m_propVars);
+			return true;
 		}
 
 #ifdef ARKSP_INVO
@@ -303,20 +377,41 @@ namespace arksp {
 #else
 		bool setNickname(const std::string & nickname) {
 #endif
-			std::regex reg("\\{@nickname\\}");			
-			for (auto& s : m_vecToken) {
-				std::get<arksp::Text>(s) = std::regex_replace(std::get<arksp::Text>(s), reg, nickname);
-			}
+			m_textVars.add("nickname", nickname);
+			refill(m_textVars, arksp::Variables());
 			return true;
 		}
 
-		arksp::token operator[](const std::vector<arksp::token>::size_type& index) {
-			auto ite = m_vecToken.begin() + index;
-			if (ite >= m_vecToken.end() || ite < m_vecToken.begin()) {
-				throw std::string("Error: Pointer of vecToken out of index");
-				return arksp::token();
+		//  With a context, placeholders are filled when a token is read, by
+		//  getToken(), getTokenView(), operator[], emitSignal(), dispatchRange()
+		//  and the Qt getters, and setNickname(), replace() and substitute() only
+		//  keep the values. A placeholder takes the value given to those first,
+		//  then the one in context. The tokens are never copied, so one Script
+		//  can serve any number of sessions, each with a Manager and a context.
+		//  nullptr goes back to filling the tokens at once. init() keeps the context.
+		void setContext(std::shared_ptr<const arksp::Variables> context) {
+			m_context = std::move(context);
+			m_mapPatch.clear();
+			if (m_context == nullptr) {
+				refill(m_textVars, m_propVars);
 			}
-			return *ite;
+			m_pointDirty = true;
+		}
+		const std::shared_ptr<const arksp::Variables>& getContext() const {
+			return m_context;
+		}
+
+		//  Fills {@key} in the text and $key in the props at once, see placeholder.hpp.
+		//  As with replace() and setNickname(), a placeholder keeps the first value it gets,
+		//  and one without a value is left as it is.
+		void substitute(const arksp::Variables& vars) {
+			m_textVars.merge(vars);
+			m_propVars.merge(vars);
+			refill(m_textVars, m_propVars);
+		}
+
+		arksp::token operator[](const std::vector<arksp::token>::size_type& index) {
+			return readAt(index, m_readScratch).toToken();
 		}
 
 		static inline std::string getValueByPropName(const std::string & name, const std::vector<std::pair<std::string, std::string>>&prop) {
@@ -327,17 +422,22 @@ namespace arksp {
 			}
 			return std::string();
 		}
+		static inline std::string_view getValueByPropName(std::string_view name, const arksp::token_view& tok) {
+			for (auto ite = tok.propBegin(); ite < tok.propEnd(); ++ite) {
+				if (ite->key == name) {
+					return ite->value;
+				}
+			}
+			return std::string_view();
+		}
 
 #ifndef ARKSP_QT
 		void emitSignal() {
-			if (m_vecToken.empty()) {
+			if (m_script->empty()) {
 				throw std::string("Error: Empty vecToken");
 				return;
 			}
-			auto strFunc = std::get<arksp::Func>(*m_iteToken), strText = std::get<arksp::Text>(*m_iteToken);
-			auto vecProp = std::get<arksp::Prop>(*m_iteToken);
-			at<std::string, SignalType>(strFunc, m_vecSig)(strText, vecProp);
-			m_globalSig(strFunc, strText, vecProp);
+			emitToken(readAt(m_index, m_emitScratch));
 			return;
 		}
 #else
@@ -346,7 +446,7 @@ namespace arksp {
 #else
 		void emitSignal() {
 #endif
-			if (m_vecToken.empty()) {
+			if (m_script->empty()) {
 #ifdef ARKSP_INVO
 				emit signalException("Error: Empty vecToken");
 #else
@@ -354,16 +454,70 @@ namespace arksp {
 #endif
 				return;
 			}
+			emitToken(readAt(m_index, m_emitScratch));
+		}
+#endif
 
-			QVariantMap qvm;
-			for (auto s : std::get<arksp::Prop>(*m_iteToken)) {
-				qvm[QString::fromStdString(s.first)] = QString::fromStdString(s.second);
-			}
-			emit signalToken(QString::fromStdString(std::get<arksp::Func>(*m_iteToken)),
-				qvm,
-				QString::fromStdString(std::get<arksp::Text>(*m_iteToken)));
+		//  Emits the tokens in [begin, end) in one loop, the same as emitSignal()
+		//  and ptrForward() one by one. If stop is given, pauses before the first
+		//  token after begin for which stop(token_view) returns true, and leaves
+		//  the pointer on it, so it can be read with getTokenView() and the loop
+		//  resumed with dispatchRange(getIndex(), ...). Otherwise the pointer is
+		//  left on the last token emitted.
+		//  Returns the index of the first token not emitted (end if not paused).
+		sizeType dispatchRange(const sizeType& begin, const sizeType& end) {
+			return dispatchRange(begin, end, [](const arksp::token_view&) { return false; });
+		}
+		sizeType dispatchRange(const sizeType& begin, const sizeType& end, const arksp::Command& stop) {
+			return dispatchRange(begin, end, [stop](const arksp::token_view& tok) { return tok.funcId == stop; });
 		}
+		template<typename Stop, typename = std::enable_if_t<!std::is_same<std::decay_t<Stop>, arksp::Command>::value>>
+		sizeType dispatchRange(const sizeType& begin, const sizeType& end, Stop&& stop) {
+			if (begin > end || end > m_script->size()) {
+#ifdef ARKSP_INVO
+				emit signalException("Error: Out of index");
+#else
+				throw std::string("Error: Out of index");
 #endif
+				return begin;
+			}
+			if (begin == end) {
+				return end;
+			}
+			auto first = m_script->begin();  //  the range is checked above
+			const bool direct = m_mapPatch.empty() && m_context == nullptr;
+			emitToken(readAt(begin, m_emitScratch));
+			for (auto i = begin + 1; i < end; ++i) {
+				auto& tok = direct ? first[i] : readAt(i, m_emitScratch);
+				if (stop(tok)) {
+					m_index = i;
+					return m_index;
+				}
+				emitToken(tok);
+			}
+			m_index = end - 1;
+			return end;
+		}
+		sizeType dispatchAll() {
+			return dispatchRange(0, m_script->size());
+		}
+		template<typename Stop>
+		sizeType dispatchAll(Stop&& stop) {
+			return dispatchRange(0, m_script->size(), std::forward<Stop>(stop));
+		}
+
+		//  Lexes and emits the tokens of stream one by one without storing them,
+		//  the tokens of the Manager and the pointer are left alone.
+		//  Returns the number of tokens emitted.
+		std::size_t emitStream(arksp::TokenStream& stream) {
+			std::size_t ret = 0;
+			arksp::token_view tok;
+			while (stream.next(tok)) {
+				emitToken(tok);
+				++ret;
+			}
+			return ret;
+		}
 
 #ifdef ARKSP_QT
 	signals:
@@ -395,11 +549,229 @@ namespace arksp {
 
 	private:
 #ifndef ARKSP_QT
-		typedef boost::signals2::signal<void(std::string, std::vector<std::pair<std::string, std::string>>)> SignalType;
-		std::vector<std::pair<std::string, SignalType>> m_vecSig;
-		boost::signals2::signal<void(std::string, std::string, std::vector<std::pair<std::string, std::string>>)> m_globalSig;
+		void emitToken(const arksp::token_view& tok) {
+			auto sig = findSignal(tok.funcId, tok.func);
+			if (sig != nullptr) {
+				(*sig)(tok);
+			}
+			m_globalSig(tok);
+		}
+
+		template<typename F>
+		static std::function<void(ARKSP_SIGNAL_VIEW())> adapt(F&& slot) {
+			using Slot = std::decay_t<F>;
+			if constexpr (std::is_same<Slot, std::function<void(ARKSP_SIGNAL_GLOBAL(,,))>>::value) {
+				return [slot = std::forward<F>(slot)](ARKSP_SIGNAL_VIEW(tok)) {
+					auto t = tok.toToken();
+					slot(std::move(std::get<arksp::Func>(t)), std::move(std::get<arksp::Text>(t)), std::move(std::get<arksp::Prop>(t)));
+				};
+			}
+			else {
+				return [slot = std::forward<F>(slot)](ARKSP_SIGNAL_VIEW(tok)) {
+					auto t = tok.toToken();
+					slot(std::move(std::get<arksp::Text>(t)), std::move(std::get<arksp::Prop>(t)));
+				};
+			}
+		}
+
+		typedef typename Dispatch::SignalType SignalType;
+
+		//  Builtin commands are indexed by ID, the others are looked up by name.
+		//  Only connect() adds signals, emitting an unknown name adds nothing.
+		//  std::less<> lets find() take a std::string_view without a copy.
+		SignalType& signalOf(const std::string& func_name) {
+			auto cmd = arksp::commandOf(func_name);
+			if (cmd != arksp::Command::Unknown) {
+				return m_arrSig[static_cast<std::size_t>(cmd)];
+			}
+			return m_mapSig[func_name];
+		}
+		SignalType* findSignal(const arksp::Command& cmd, std::string_view func_name) {
+			if (cmd != arksp::Command::Unknown && cmd < arksp::Command::Count) {
+				return &m_arrSig[static_cast<std::size_t>(cmd)];
+			}
+			if (m_mapSig.empty()) {
+				return nullptr;
+			}
+			auto ite = m_mapSig.find(func_name);
+			return ite != m_mapSig.end() ? &ite->second : nullptr;
+		}
+
+		std::array<SignalType, static_cast<std::size_t>(arksp::Command::Count)> m_arrSig;
+		std::map<std::string, SignalType, std::less<>> m_mapSig;
+		SignalType m_globalSig;
+#else
+		void emitToken(const arksp::token_view& tok) {
+			emit signalToken(toQString(tok.func), toPropMap(tok), toQString(tok.text));
+		}
+#endif
+
+#ifdef ARKSP_QT
+		static inline QString toQString(std::string_view str) {
+			return QString::fromUtf8(str.data(), static_cast<int>(str.size()));
+		}
+		static inline QVariantMap toPropMap(const arksp::token_view& tok) {
+			QVariantMap qvm;
+			for (auto ite = tok.propBegin(); ite < tok.propEnd(); ++ite) {
+				qvm[toQString(ite->key)] = toQString(ite->value);
+			}
+			return qvm;
+		}
 #endif
-		std::vector<arksp::token> m_vecToken;
-		std::vector<arksp::token>::iterator m_iteToken;		
+
+		//  positions of the predicate tokens by their references, in ascending order
+		void indexPoints() {
+			m_mapPoint.clear();
+			Resolved scratch;
+			for (sizeType i = 0; i < m_script->size(); ++i) {
+				if (tokenAt(i).funcId == arksp::Command::Predicate) {
+					m_mapPoint[std::string(getValueByPropName("references", readAt(i, scratch)))].push_back(i);
+				}
+			}
+			m_pointDirty = false;
+		}
+
+		//  the token as this Manager sees it, with the changes of replace() and setNickname()
+		const arksp::token_view& tokenAt(const sizeType& index) const {
+			if (!m_mapPatch.empty()) {
+				auto ite = m_mapPatch.find(index);
+				if (ite != m_mapPatch.end()) {
+					return ite->second.tok;
+				}
+			}
+			return (*m_script)[index];
+		}
+		//  a token with its placeholders filled from the context, see setContext()
+		struct Resolved {
+			arksp::token_view tok;
+			std::vector<arksp::prop_view> props;
+			std::string buf;
+			std::vector<std::pair<std::uint32_t, std::string::size_type>> spans;  //  prop, start in buf
+		};
+		//  The result is valid until scratch is used again. m_readScratch is for
+		//  the getters and m_emitScratch for emitting, so a slot can call the getters.
+		const arksp::token_view& readAt(const sizeType& index, Resolved& scratch) const {
+			return m_context != nullptr ? resolve(index, scratch) : tokenAt(index);
+		}
+		const arksp::token_view& resolve(const sizeType& index, Resolved& out) const {
+			auto& tok = (*m_script)[index];
+			auto range = m_script->placeholdersOf(index);
+			if (range.first == range.second) {
+				return tok;
+			}
+			out.buf.clear();
+			out.spans.clear();
+			for (auto ite = range.first; ite < range.second;) {
+				auto first = ite;
+				while (ite < range.second && ite->prop == first->prop) {
+					++ite;
+				}
+				const bool isText = first->prop == arksp::placeholder::Text;
+				const arksp::Variables& vars = isText ? m_textVars : m_propVars;
+				auto start = out.buf.size();
+				if (arksp::fillString(isText ? tok.text : tok.props[first->prop].value, first, ite,
+					[this, &vars](std::string_view key) {
+						auto value = vars.find(key);
+						return value != nullptr ? value : m_context->find(key);
+					}, out.buf)) {
+					out.spans.push_back({ first->prop,start });
+				}
+				else {
+					out.buf.resize(start);
+				}
+			}
+			if (out.spans.empty()) {
+				return tok;
+			}
+			//  buf is complete, the views can point into it now
+			out.tok = tok;
+			out.props.assign(tok.propBegin(), tok.propEnd());
+			out.tok.props = out.props.data();
+			for (std::size_t i = 0; i < out.spans.size(); ++i) {
+				auto start = out.spans[i].second;
+				auto end = i + 1 < out.spans.size() ? out.spans[i + 1].second : out.buf.size();
+				auto str = std::string_view(out.buf).substr(start, end - start);
+				if (out.spans[i].first == arksp::placeholder::Text) {
+					out.tok.text = str;
+				}
+				else {
+					out.props[out.spans[i].first].value = str;
+				}
+			}
+			return out.tok;
+		}
+
+		//  Copy on write: the first change of a token copies it and its props
+		//  into m_mapPatch. The new strings are kept in the Patch, changing
+		//  the token again replaces them.
+		struct Patch {
+			arksp::token_view tok;
+			std::vector<arksp::prop_view> props;
+			std::string text;
+			std::vector<std::string> values;  //  one for each prop
+		};
+		Patch& patchOf(const sizeType& index) {
+			auto ite = m_mapPatch.find(index);
+			if (ite != m_mapPatch.end()) {
+				return ite->second;
+			}
+			auto& tok = (*m_script)[index];
+			auto& ret = m_mapPatch[index];
+			ret.tok = tok;
+			ret.props.assign(tok.propBegin(), tok.propEnd());
+			ret.values.resize(ret.props.size());  //  never resized again, the views point into them
+			ret.tok.props = ret.props.data();  //  node of unordered_map never moves
+			return ret;
+		}
+		void setText(const sizeType& index, std::string text) {
+			auto& patch = patchOf(index);
+			patch.text = std::move(text);
+			patch.tok.text = patch.text;
+		}
+		void setValue(const sizeType& index, const std::uint32_t& prop, std::string value) {
+			auto& patch = patchOf(index);
+			patch.values[prop] = std::move(value);
+			patch.props[prop].value = patch.values[prop];
+		}
+
+		//  fills the placeholders of the Script from the values given so far,
+		//  pass an empty Variables to skip the text or the props
+		void refill(const arksp::Variables& text, const arksp::Variables& props) {
+			if (m_context != nullptr) {  //  filled when read
+				m_pointDirty = true;
+				return;
+			}
+			arksp::fill(*m_script, text, props, [this](const sizeType& token, const std::uint32_t& prop, std::string filled) {
+				if (prop == arksp::placeholder::Text) {
+					if (tokenAt(token).text != filled) {
+						setText(token, std::move(filled));
+					}
+				}
+				else if (tokenAt(token).props[prop].value != filled) {
+					setValue(token, prop, std::move(filled));
+					m_pointDirty = true;  //  might be a references
+				}
+			});
+		}
+
+		static const std::shared_ptr<const arksp::Script>& emptyScript() {
+			static const std::shared_ptr<const arksp::Script> ret = std::make_shared<const arksp::Script>();
+			return ret;
+		}
+
+		std::shared_ptr<const arksp::Script> m_script = emptyScript();  //  never nullptr
+		std::unordered_map<sizeType, Patch> m_mapPatch;
+		arksp::Variables m_textVars;  //  setNickname()
+		arksp::Variables m_propVars;  //  replace()
+		std::shared_ptr<const arksp::Variables> m_context;
+		Resolved m_readScratch;
+		Resolved m_emitScratch;
+		sizeType m_index = 0;
+		std::unordered_map<std::string, std::vector<sizeType>> m_mapPoint;
+		bool m_pointDirty = false;
 	};
+
+#ifndef ARKSP_QT
+	typedef BasicManager<arksp::SignalsDispatch> Manager;
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+//  Fills the placeholders of a Script: {@key} anywhere in the text of a
+//  token, e.g. {@nickname}, and prop values that are $key as a whole.
+//  Where they are is found once when the Script is made (Script::placeholders()),
+//  filling is one pass over each string that has any.
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <sstream>
+#include <functional>
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/json_parser.hpp>
+
+#include "core.hpp"
+#include "script.hpp"
+
+namespace arksp {
+	//  Values of the placeholders by key, a flat key/value map.
+	class Variables {
+	public:
+		Variables() {}
+		Variables(std::initializer_list<std::pair<const std::string, std::string>> list)
+			: m_map(list) {}
+		//  any map or vector of pairs of strings
+		template<typename Map>
+		static Variables fromMap(const Map& map) {
+			Variables ret;
+			for (auto& s : map) {
+				ret.set(s.first, s.second);
+			}
+			return ret;
+		}
+		//  Nested objects become dotted keys, {"a":{"b":"1"}} is a.b = 1, the
+		//  same path as boost::property_tree::ptree::get_child().
+		//  Throws what boost::property_tree::read_json() throws.
+		static Variables fromJson(const std::string& json) {
+			boost::property_tree::ptree root;
+			std::stringstream ss(json);
+			boost::property_tree::read_json(ss, root);
+			Variables ret;
+			ret.addTree(std::string(), root);
+			return ret;
+		}
+
+		//  replaces the value if key is there
+		void set(const std::string& key, const std::string& value) {
+			m_map[key] = value;
+		}
+		//  keeps the value if key is there, returns whether value is added
+		bool add(const std::string& key, const std::string& value) {
+			return m_map.emplace(key, value).second;
+		}
+		void merge(const Variables& other) {
+			for (auto& s : other.m_map) {
+				m_map.emplace(s.first, s.second);
+			}
+		}
+		//  nullptr if key isn't there
+		const std::string* find(std::string_view key) const {
+			auto ite = m_map.find(key);
+			return ite != m_map.end() ? &ite->second : nullptr;
+		}
+
+		bool empty() const {
+			return m_map.empty();
+		}
+		std::size_t size() const {
+			return m_map.size();
+		}
+
+	private:
+		void addTree(const std::string& path, const boost::property_tree::ptree& tree) {
+			m_map.emplace(path, tree.data());  //  the first of duplicated keys wins, as get_child()
+			for (auto& s : tree) {
+				addTree(path.empty() ? s.first : path + "." + s.first, s.second);
+			}
+		}
+
+		std::map<std::string, std::string, std::less<>> m_map;  //  std::less<> looks up string_view without a copy
+	};
+
+	//  Fills the placeholders [first, last) of str, which must all be in str,
+	//  and appends the result to out. find(key) gives a const std::string* to
+	//  the value, or nullptr to keep the placeholder as it is.
+	//  Returns whether any placeholder got a value.
+	template<typename Find>
+	inline bool fillString(std::string_view str, const arksp::placeholder* first, const arksp::placeholder* last, Find&& find, std::string& out) {
+		std::string_view::size_type pos = 0;
+		bool ret = false;
+		for (; first < last; ++first) {
+			out.append(str.data() + pos, first->begin - pos);
+			const std::string* value = find(first->key);
+			if (value != nullptr) {
+				out += *value;
+				ret = true;
+			}
+			else {
+				out.append(str.data() + first->begin, first->end - first->begin);
+			}
+			pos = first->end;
+		}
+		out.append(str.data() + pos, str.size() - pos);
+		return ret;
+	}
+
+	//  Fills the placeholders of script. {@key} takes its value from text,
+	//  $key from props, pass the same Variables twice to fill both from one map.
+	//  For every string that has a placeholder with a value,
+	//  out(token, prop, filled) is called once, prop is placeholder::Text for
+	//  the text. Placeholders without a value are kept as they are.
+	//  Returns the number of strings filled.
+	template<typename Out>
+	inline std::size_t fill(const arksp::Script& script, const arksp::Variables& text, const arksp::Variables& props, Out&& out) {
+		auto& vec = script.placeholders();
+		const arksp::placeholder* const end = vec.data() + vec.size();
+		std::size_t ret = 0;
+		std::string filled;
+		for (const arksp::placeholder* ite = vec.data(); ite < end;) {
+			auto first = ite;
+			while (ite < end && ite->token == first->token && ite->prop == first->prop) {
+				++ite;
+			}
+			auto& tok = script[first->token];
+			const bool isText = first->prop == arksp::placeholder::Text;
+			const arksp::Variables& vars = isText ? text : props;
+			filled.clear();
+			if (fillString(isText ? tok.text : tok.props[first->prop].value, first, ite,
+				[&vars](std::string_view key) { return vars.find(key); }, filled)) {
+				out(static_cast<arksp::Script::sizeType>(first->token), first->prop, std::string(filled));
+				++ret;
+			}
+		}
+		return ret;
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+//  Memory resources to pass to Lexer::lex(). CountingResource counts what
+//  goes through it, to see how much a parse allocates and that nothing
+//  else is allocated from it afterwards.
+
+#include <memory_resource>
+#include <atomic>
+#include <cstddef>
+
+namespace arksp {
+	class CountingResource : public std::pmr::memory_resource {
+	public:
+		explicit CountingResource(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+			: m_upstream(upstream) {}
+
+		//  calls of allocate() and deallocate()
+		std::size_t allocations() const {
+			return m_allocations;
+		}
+		std::size_t deallocations() const {
+			return m_deallocations;
+		}
+		//  bytes of all the allocate() calls, and of the ones not deallocated yet
+		std::size_t bytes() const {
+			return m_bytes;
+		}
+		std::size_t bytesInUse() const {
+			return m_bytesInUse;
+		}
+
+		void reset() {
+			m_allocations = 0;
+			m_deallocations = 0;
+			m_bytes = 0;
+			m_bytesInUse = 0;
+		}
+
+	private:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+			void* ret = m_upstream->allocate(bytes, alignment);
+			++m_allocations;
+			m_bytes += bytes;
+			m_bytesInUse += bytes;
+			return ret;
+		}
+		void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+			m_upstream->deallocate(p, bytes, alignment);
+			++m_deallocations;
+			m_bytesInUse -= bytes;
+		}
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+			return this == &other;
+		}
+
+		std::pmr::memory_resource* m_upstream;
+		std::atomic<std::size_t> m_allocations{ 0 };
+		std::atomic<std::size_t> m_deallocations{ 0 };
+		std::atomic<std::size_t> m_bytes{ 0 };
+		std::atomic<std::size_t> m_bytesInUse{ 0 };
+	};
+}
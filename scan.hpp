@@ -0,0 +1,89 @@
+#pragma once
+
+//  Finds structural characters 16 or 32 bytes at a time.
+//  The instruction set is chosen at compile time: AVX2 if the compiler
+//  targets it (-mavx2, /arch:AVX2), otherwise SSE2 on x86 / x64, otherwise
+//  plain loops. Define ARKSP_NO_SIMD to always use the plain loops.
+
+#if !defined(ARKSP_NO_SIMD)
+#if defined(__AVX2__)
+#define ARKSP_SCAN_AVX2
+#define ARKSP_SCAN_SSE2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ARKSP_SCAN_SSE2
+#endif
+#endif
+
+#if defined(ARKSP_SCAN_AVX2)
+#include <immintrin.h>
+#elif defined(ARKSP_SCAN_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(ARKSP_SCAN_SSE2) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include <string_view>
+
+namespace arksp {
+	namespace scan {
+#ifdef ARKSP_SCAN_SSE2
+		static inline unsigned first_bit(unsigned mask) {
+#ifdef _MSC_VER
+			unsigned long ret;
+			_BitScanForward(&ret, mask);
+			return static_cast<unsigned>(ret);
+#else
+			return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+		}
+#endif
+
+		//  first character in [b, e) that is one of Cs, or e
+		template<char... Cs>
+		inline const char* find_any(const char* b, const char* e) {
+#ifdef ARKSP_SCAN_AVX2
+			while (e - b >= 32) {
+				const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+				__m256i m = _mm256_setzero_si256();
+				((m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(Cs)))), ...);
+				const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(m));
+				if (mask != 0) {
+					return b + first_bit(mask);
+				}
+				b += 32;
+			}
+#endif
+#ifdef ARKSP_SCAN_SSE2
+			while (e - b >= 16) {
+				const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+				__m128i m = _mm_setzero_si128();
+				((m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(Cs)))), ...);
+				const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(m));
+				if (mask != 0) {
+					return b + first_bit(mask);
+				}
+				b += 16;
+			}
+#endif
+			for (; b < e; ++b) {
+				if (((*b == Cs) || ...)) {
+					return b;
+				}
+			}
+			return e;
+		}
+
+		//  the same, as an index into str starting from pos, or std::string_view::npos
+		template<char... Cs>
+		inline std::string_view::size_type find_any(std::string_view str, std::string_view::size_type pos) {
+			if (pos >= str.size()) {
+				return std::string_view::npos;
+			}
+			const char* const e = str.data() + str.size();
+			const char* const p = find_any<Cs...>(str.data() + pos, e);
+			return p == e ? std::string_view::npos : static_cast<std::string_view::size_type>(p - str.data());
+		}
+	}
+}
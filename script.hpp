@@ -0,0 +1,204 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <algorithm>
+
+#include "core.hpp"
+#include "symbol.hpp"
+#include "scan.hpp"
+
+namespace arksp {
+	//  A lexed script. Every token_view and prop_view in it points into
+	//  m_source, which is owned by the Script and never changes after lexing,
+	//  or into the tokens given to fromTokens().
+	//  Script is move-only, moving it doesn't invalidate any view. It is never
+	//  changed after it is made, so Managers can share one through shared_ptr.
+	//  The arrays of views are allocated from the memory_resource given to
+	//  Lexer::lex(), the Script must be gone before the resource is.
+	class Script {
+	public:
+		using sizeType = std::pmr::vector<arksp::token_view>::size_type;
+		using const_iterator = std::pmr::vector<arksp::token_view>::const_iterator;
+
+		Script() {}
+		explicit Script(std::pmr::memory_resource* resource)
+			: m_vecToken(resource), m_vecProp(resource), m_vecHolder(resource) {}
+		Script(Script&&) = default;
+		//  Keeps the resource of this, as pmr containers do, construct from
+		//  other to take its resource too. A pmr vector only takes the buffer
+		//  of another one with the same resource and copies the elements
+		//  otherwise, then the props of the tokens are pointed at the copy.
+		//  If a copy throws, this is left as it was.
+		Script& operator=(Script&& other) {
+			if (this == &other) {
+				return *this;
+			}
+			const arksp::prop_view* const oldProps = other.m_vecProp.data();
+			std::pmr::vector<arksp::token_view> tokens(std::move(other.m_vecToken), resource());
+			std::pmr::vector<arksp::prop_view> props(std::move(other.m_vecProp), resource());
+			std::pmr::vector<arksp::placeholder> holders(std::move(other.m_vecHolder), resource());
+			if (props.data() != oldProps) {
+				for (auto& tok : tokens) {
+					if (tok.props != nullptr) {
+						tok.props = props.data() + (tok.props - oldProps);
+					}
+				}
+			}
+			//  the same resource on both sides from here, nothing throws
+			m_vecToken.swap(tokens);
+			m_vecProp.swap(props);
+			m_vecHolder.swap(holders);
+			m_source = std::move(other.m_source);
+			m_keep = std::move(other.m_keep);
+			m_vecBacking = std::move(other.m_vecBacking);
+			m_symbols = std::move(other.m_symbols);
+			return *this;
+		}
+		Script(const Script&) = delete;
+		Script& operator=(const Script&) = delete;
+
+		sizeType size() const {
+			return m_vecToken.size();
+		}
+		bool empty() const {
+			return m_vecToken.empty();
+		}
+		const_iterator begin() const {
+			return m_vecToken.begin();
+		}
+		const_iterator end() const {
+			return m_vecToken.end();
+		}
+
+		const arksp::token_view& operator[](const sizeType& index) const {
+			if (index >= m_vecToken.size()) {
+				throw std::string("Error: Pointer of vecToken out of index");
+			}
+			return m_vecToken[index];
+		}
+
+		//  the whole (normalized) buffer every view points into
+		std::string_view source() const {
+			return m_source ? std::string_view(*m_source) : std::string_view();
+		}
+
+		//  names of the funcId and keyId in the views
+		const arksp::Symbols& symbols() const {
+			return m_symbols;
+		}
+
+		arksp::token toToken(const sizeType& index) const {
+			return (*this)[index].toToken();
+		}
+
+		std::pmr::memory_resource* resource() const {
+			return m_vecToken.get_allocator().resource();
+		}
+
+		//  every {@key} and $key, found once when the Script is made, see placeholder.hpp
+		const std::pmr::vector<arksp::placeholder>& placeholders() const {
+			return m_vecHolder;
+		}
+		//  the placeholders of one token
+		std::pair<const arksp::placeholder*, const arksp::placeholder*> placeholdersOf(const sizeType& index) const {
+			const arksp::placeholder* const b = m_vecHolder.data();
+			const arksp::placeholder* const e = b + m_vecHolder.size();
+			auto first = std::lower_bound(b, e, index, [](const arksp::placeholder& ph, const sizeType& i) { return ph.token < i; });
+			auto last = first;
+			while (last < e && last->token == index) {
+				++last;
+			}
+			return { first,last };
+		}
+
+		//  Wraps tokens that are already lexed. The Script keeps tokens and
+		//  points into its strings, nothing is copied.
+		static Script fromTokens(std::vector<arksp::token> tokens) {
+			Script ret;
+			ret.m_vecBacking = std::move(tokens);
+			std::vector<arksp::token>::size_type nProp = 0;
+			for (auto& s : ret.m_vecBacking) {
+				nProp += std::get<arksp::Prop>(s).size();
+			}
+			ret.m_vecToken.reserve(ret.m_vecBacking.size());
+			ret.m_vecProp.reserve(nProp);  //  never reallocates below
+			for (auto& s : ret.m_vecBacking) {
+				arksp::token_view tok;
+				tok.func = std::get<arksp::Func>(s);
+				tok.funcId = ret.m_symbols.funcs.intern(tok.func);
+				tok.text = std::get<arksp::Text>(s);
+				tok.props = ret.m_vecProp.data() + ret.m_vecProp.size();
+				for (auto& i : std::get<arksp::Prop>(s)) {
+					ret.m_vecProp.push_back({ i.first,i.second,ret.m_symbols.keys.intern(i.first) });
+				}
+				tok.propCount = static_cast<std::uint32_t>(std::get<arksp::Prop>(s).size());
+				findPlaceholders(ret.m_vecHolder, ret.m_vecToken.size(), tok, tok.props);
+				ret.m_vecToken.push_back(tok);
+			}
+			return ret;
+		}
+
+		//  the same result as Lexer::lexer()
+		std::vector<arksp::token> materialize() const {
+			std::vector<arksp::token> ret;
+			ret.reserve(m_vecToken.size());
+			for (auto& s : m_vecToken) {
+				ret.push_back(s.toToken());
+			}
+			return ret;
+		}
+
+	private:
+		friend class Lexer;
+		friend class Binary;
+		friend class Corpus;
+
+		//  Called for each token in order, while its props are still hot.
+		//  The placeholders of a token are added props first, then text.
+		template<typename Vec>
+		static void findPlaceholders(Vec& vec, const sizeType& index, const arksp::token_view& tok, const arksp::prop_view* props) {
+			arksp::placeholder ph;
+			ph.token = static_cast<std::uint32_t>(index);
+			for (std::uint32_t j = 0; j < tok.propCount; ++j) {
+				auto value = props[j].value;
+				if (!value.empty() && value[0] == '$') {
+					ph.prop = j;
+					ph.begin = 0;
+					ph.end = static_cast<std::uint32_t>(value.size());
+					ph.key = value.substr(1);
+					vec.push_back(ph);
+				}
+			}
+			ph.prop = arksp::placeholder::Text;
+			auto pos = scan::find_any<'{'>(tok.text, 0);
+			while (pos != std::string_view::npos) {
+				if (pos + 1 < tok.text.size() && tok.text[pos + 1] == '@') {
+					auto close = tok.text.find_first_of("{}", pos + 2);
+					if (close != std::string_view::npos && tok.text[close] == '}') {
+						ph.begin = static_cast<std::uint32_t>(pos);
+						ph.end = static_cast<std::uint32_t>(close + 1);
+						ph.key = tok.text.substr(pos + 2, close - pos - 2);
+						vec.push_back(ph);
+						pos = scan::find_any<'{'>(tok.text, close + 1);
+						continue;
+					}
+				}
+				pos = scan::find_any<'{'>(tok.text, pos + 1);
+			}
+		}
+
+		//  held by pointer so that moving the Script doesn't move the characters
+		std::unique_ptr<std::string> m_source;
+		std::shared_ptr<const void> m_keep;  //  whatever else the views point into, e.g. the file mapped by Binary::load()
+		std::vector<arksp::token> m_vecBacking;
+		std::pmr::vector<arksp::token_view> m_vecToken;
+		std::pmr::vector<arksp::prop_view> m_vecProp;
+		std::pmr::vector<arksp::placeholder> m_vecHolder;
+		arksp::Symbols m_symbols;
+	};
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <istream>
+
+#include "core.hpp"
+#include "lexer.hpp"
+#include "scan.hpp"
+
+namespace arksp {
+	//  Pull-style lexer. Tokens are lexed on demand from a std::istream, or
+	//  from chunks given to feed(), so the first line can be used before the
+	//  rest of the script arrives. A line may span any number of chunks.
+	//  The tokens and the line numbers in errors are the same as Lexer::lexer().
+	class TokenStream {
+	public:
+		//  chunk mode, call feed() and close()
+		TokenStream() {}
+		explicit TokenStream(std::istream& is, const std::size_t& chunk = 64 * 1024)
+			: m_is(&is), m_chunk(chunk) {}
+
+		void feed(std::string_view chunk) {
+			compact();
+			m_buf.append(chunk.data(), chunk.size());
+			m_read += chunk.size();
+		}
+		//  no more chunks, the last line doesn't need a line break
+		void close() {
+			m_closed = true;
+		}
+
+		//  The view is valid until the next call of next() or feed().
+		//  Returns false if there is no complete line buffered yet (chunk mode)
+		//  or if the script is finished, use done() to tell them apart.
+		bool next(arksp::token_view& tok) {
+			std::string_view s;
+			while (nextLine(s)) {
+				if (Lexer::scan_line(s, m_iCount, m_parts)) {
+					m_vecProp.clear();
+					tok = Lexer::view_line(m_parts, m_vecProp, m_symbols);
+					tok.props = m_vecProp.data();
+					return true;
+				}
+			}
+			return false;
+		}
+		bool next(arksp::token& tok) {
+			arksp::token_view view;
+			if (!next(view)) {
+				return false;
+			}
+			tok = view.toToken();
+			return true;
+		}
+
+		bool done() const {
+			return m_done;
+		}
+		//  line number of the last token
+		int line() const {
+			return m_iCount;
+		}
+		//  names of the funcId and keyId in the views
+		const arksp::Symbols& symbols() const {
+			return m_symbols;
+		}
+
+	private:
+		//  LineCursor::next(), but the end of the buffer isn't always the end of the text
+		bool nextLine(std::string_view& line) {
+			while (!m_done) {
+				if (m_skip) {
+					while (m_pos < m_buf.size() && m_buf[m_pos] == '\n') {
+						++m_pos;
+					}
+					if (m_pos < m_buf.size()) {
+						m_skip = false;
+						m_scan = m_pos;
+					}
+				}
+				if (!m_skip) {
+					auto eol = scan::find_any<'\n'>(m_buf, m_scan);
+					if (eol != std::string::npos) {
+						++m_iCount;
+						line = std::string_view(m_buf).substr(m_pos, eol - m_pos);
+						m_pos = m_scan = eol + 1;
+						m_skip = true;
+						return true;
+					}
+					m_scan = m_buf.size();
+				}
+				if (fill()) {
+					continue;
+				}
+				if (!m_closed) {
+					return false;
+				}
+				m_done = true;
+				if (m_read == 0) {
+					throw std::string("Error: Empty Text");
+				}
+				//  the last line, or the empty one after the last line break
+				++m_iCount;
+				line = std::string_view(m_buf).substr(m_pos);
+				m_pos = m_scan = m_buf.size();
+				return true;
+			}
+			return false;
+		}
+
+		//  reads the next chunk from the istream, if there is one
+		bool fill() {
+			if (m_is == nullptr || m_closed) {
+				return false;
+			}
+			compact();
+			auto old = m_buf.size();
+			m_buf.resize(old + m_chunk);
+			m_is->read(&m_buf[old], m_chunk);
+			auto n = static_cast<std::size_t>(m_is->gcount());
+			m_buf.resize(old + n);
+			m_read += n;
+			if (n == 0) {
+				m_closed = true;
+				return false;
+			}
+			return true;
+		}
+		void compact() {
+			if (m_pos == 0) {
+				return;
+			}
+			m_buf.erase(0, m_pos);
+			m_scan -= m_pos;
+			m_pos = 0;
+		}
+
+		std::istream* m_is = nullptr;
+		std::size_t m_chunk = 64 * 1024;
+		std::string m_buf;
+		std::string::size_type m_pos = 0;   //  start of the unread part of m_buf
+		std::string::size_type m_scan = 0;  //  where to continue looking for '\n'
+		std::size_t m_read = 0;
+		int m_iCount = 0;
+		bool m_skip = false;  //  inside a run of line breaks
+		bool m_closed = false;
+		bool m_done = false;
+
+		Lexer::LineParts m_parts;
+		std::vector<arksp::prop_view> m_vecProp;
+		arksp::Symbols m_symbols;
+	};
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <limits>
+#include <type_traits>
+#include <cstdint>
+
+namespace arksp {
+	//  Function names the library knows about, in lower case as the lexer
+	//  produces them. The value is also the symbol ID of the name.
+	enum class Command : std::uint16_t {
+		Unknown = 0,
+		PlainText,
+		Name,
+		Dialog,
+		Header,
+		Background,
+		BackgroundTween,
+		Image,
+		ImageTween,
+		Character,
+		CharacterAction,
+		Charslot,
+		Delay,
+		Blocker,
+		Decision,
+		Predicate,
+		PlayMusic,
+		StopMusic,
+		MusicVolume,
+		PlaySound,
+		StopSound,
+		CameraShake,
+		CameraEffect,
+		Subtitle,
+		Sticker,
+		StickerClear,
+		Tutorial,
+		Video,
+		Count
+	};
+
+	//  Prop keys the library knows about. Keys are case sensitive, the
+	//  enumerator is the key with its first letter capitalized.
+	enum class PropKey : std::uint16_t {
+		Unknown = 0,
+		Name,
+		Name2,
+		Image,
+		X,
+		Y,
+		Xscale,
+		Yscale,
+		XScale,
+		YScale,
+		XTo,
+		YTo,
+		XScaleTo,
+		YScaleTo,
+		Xpos,
+		Ypos,
+		Type,
+		Direction,
+		Block,
+		References,
+		Options,
+		Values,
+		Time,
+		Fadetime,
+		Key,
+		Volume,
+		Text,
+		Count
+	};
+
+	inline std::string_view nameOf(const Command& cmd) {
+		static constexpr std::string_view names[] = {
+			"", "plaintext", "name", "dialog", "header",
+			"background", "backgroundtween", "image", "imagetween",
+			"character", "characteraction", "charslot", "delay", "blocker",
+			"decision", "predicate", "playmusic", "stopmusic", "musicvolume",
+			"playsound", "stopsound", "camerashake", "cameraeffect",
+			"subtitle", "sticker", "stickerclear", "tutorial", "video"
+		};
+		static_assert(sizeof(names) / sizeof(names[0]) == static_cast<std::size_t>(Command::Count), "arksp: Command names not matched");
+		auto i = static_cast<std::size_t>(cmd);
+		return i < static_cast<std::size_t>(Command::Count) ? names[i] : std::string_view();
+	}
+	inline std::string_view nameOf(const PropKey& key) {
+		static constexpr std::string_view names[] = {
+			"", "name", "name2", "image", "x", "y",
+			"xscale", "yscale", "xScale", "yScale", "xTo", "yTo", "xScaleTo", "yScaleTo",
+			"xpos", "ypos", "type", "direction", "block", "references", "options", "values",
+			"time", "fadetime", "key", "volume", "text"
+		};
+		static_assert(sizeof(names) / sizeof(names[0]) == static_cast<std::size_t>(PropKey::Count), "arksp: PropKey names not matched");
+		auto i = static_cast<std::size_t>(key);
+		return i < static_cast<std::size_t>(PropKey::Count) ? names[i] : std::string_view();
+	}
+
+	//  Interns names into small integer IDs. A builtin name always gets its
+	//  enumerator, other names get Count, Count + 1, ... in order of appearance.
+	//  Enum is Command or PropKey.
+	template<typename Enum>
+	class SymbolTable {
+	public:
+		using idType = std::underlying_type_t<Enum>;
+
+		SymbolTable() {}
+		//  m_map points into m_storage
+		SymbolTable(const SymbolTable& other) {
+			for (auto& s : other.m_storage) {
+				intern(s);
+			}
+		}
+		SymbolTable& operator=(const SymbolTable& other) {
+			if (this != &other) {
+				SymbolTable tmp(other);
+				swap(tmp);
+			}
+			return *this;
+		}
+		SymbolTable(SymbolTable&&) = default;
+		SymbolTable& operator=(SymbolTable&&) = default;
+
+		//  Enum::Unknown only when all the IDs are used up
+		Enum intern(std::string_view name) {
+			auto builtin = builtins().find(name);
+			if (builtin != builtins().end()) {
+				return builtin->second;
+			}
+			auto ite = m_map.find(name);
+			if (ite != m_map.end()) {
+				return ite->second;
+			}
+			auto id = static_cast<std::size_t>(Enum::Count) + m_storage.size();
+			if (id > static_cast<std::size_t>(std::numeric_limits<idType>::max())) {
+				return Enum::Unknown;
+			}
+			m_storage.emplace_back(name);
+			m_map.emplace(m_storage.back(), static_cast<Enum>(id));
+			return static_cast<Enum>(id);
+		}
+		//  Enum::Unknown if name isn't interned
+		Enum find(std::string_view name) const {
+			auto builtin = builtins().find(name);
+			if (builtin != builtins().end()) {
+				return builtin->second;
+			}
+			auto ite = m_map.find(name);
+			return ite != m_map.end() ? ite->second : Enum::Unknown;
+		}
+		std::string_view name(const Enum& id) const {
+			auto i = static_cast<std::size_t>(id);
+			if (i < static_cast<std::size_t>(Enum::Count)) {
+				return nameOf(id);
+			}
+			i -= static_cast<std::size_t>(Enum::Count);
+			return i < m_storage.size() ? std::string_view(m_storage[i]) : std::string_view();
+		}
+		std::size_t size() const {
+			return static_cast<std::size_t>(Enum::Count) + m_storage.size();
+		}
+
+		void swap(SymbolTable& other) {
+			m_map.swap(other.m_map);
+			m_storage.swap(other.m_storage);
+		}
+
+	private:
+		//  shared by all tables, so a new table allocates nothing until a name
+		//  that isn't builtin is interned
+		static const std::unordered_map<std::string_view, Enum>& builtins() {
+			static const std::unordered_map<std::string_view, Enum> map = [] {
+				std::unordered_map<std::string_view, Enum> ret;
+				for (idType i = 1; i < static_cast<idType>(Enum::Count); ++i) {
+					ret.emplace(nameOf(static_cast<Enum>(i)), static_cast<Enum>(i));
+				}
+				return ret;
+			}();
+			return map;
+		}
+
+		std::unordered_map<std::string_view, Enum> m_map;  //  names that aren't builtin
+		std::deque<std::string> m_storage;  //  deque doesn't move its elements on push_back
+	};
+
+	struct Symbols {
+		SymbolTable<Command> funcs;
+		SymbolTable<PropKey> keys;
+	};
+
+	//  Command::Unknown for anything not builtin
+	inline Command commandOf(std::string_view func) {
+		static const SymbolTable<Command> table;
+		return table.find(func);
+	}
+	inline PropKey propKeyOf(std::string_view key) {
+		static const SymbolTable<PropKey> table;
+		return table.find(key);
+	}
+}
@@ -0,0 +1,81 @@
+//  FrameStore of videocore.hpp, needs OpenCV:
+//    g++ -std=c++17 -DARKSP_CONTEXT -I.. framestore.cpp -lopencv_core -o framestore && ./framestore
+//  Prints the checks that fail, returns 1 if any does.
+
+#include <iostream>
+
+#include "../videocore.hpp"
+
+namespace {
+	int failed = 0;
+
+	void check(const bool& ok, const char* what) {
+		if (!ok) {
+			std::cout << "failed: " << what << "\n";
+			++failed;
+		}
+	}
+}
+
+int main() {
+	{
+		//  a Mat pushed twice shares its buffer, dropping one copy mustn't pool it
+		arksp::FrameStore frames;
+		cv::Mat a(4, 4, CV_8UC4);
+		frames.push_back(a);
+		frames.push_back(a);
+		a.release();
+		frames.truncate(1);
+		check(frames.pooled() == 0, "a buffer a kept run shares isn't pooled");
+		cv::Mat b = frames.acquire(4, 4, CV_8UC4);
+		check(b.data != frames[0].data, "acquire() doesn't return the buffer of a kept frame");
+	}
+	{
+		//  the caller still has the Mat it pushed
+		arksp::FrameStore frames;
+		cv::Mat a(4, 4, CV_8UC4);
+		frames.push_back(a, 3);
+		frames.clear();
+		check(frames.pooled() == 0, "a buffer the caller shares isn't pooled");
+		cv::Mat b = frames.acquire(4, 4, CV_8UC4);
+		check(b.data != a.data, "acquire() doesn't return a buffer the caller has");
+	}
+	{
+		//  a buffer only the store has is reused
+		arksp::FrameStore frames;
+		frames.push_back(frames.acquire(4, 4, CV_8UC4), 5);
+		const unsigned char* data = frames[0].data;
+		frames.clear();
+		check(frames.pooled() == 1, "a buffer only the store has is pooled");
+		cv::Mat b = frames.acquire(4, 4, CV_8UC4);
+		check(b.data == data, "acquire() reuses it for the same size and type");
+		check(frames.pooled() == 0, "and takes it out of the pool");
+	}
+	{
+		//  two runs of one buffer dropped together pool it once
+		arksp::FrameStore frames;
+		cv::Mat a(4, 4, CV_8UC4);
+		frames.push_back(a);
+		frames.push_back(a, 2);
+		a.release();
+		frames.clear();
+		check(frames.pooled() == 1, "a buffer of two dropped runs is pooled once");
+	}
+	{
+		//  runs over the logical frames
+		arksp::Component component;
+		component.upFit(3);
+		check(component.getFrameNumber() == 3 && component.frames().runs().size() == 1, "upFit() of an empty Component is one run");
+		component.frames().push_back(component.frames().acquire(2, 2, CV_8UC4));
+		component.upFit(1000);
+		std::size_t n = 0;
+		for (auto ite = component.begin(); ite != component.end(); ++ite) {
+			++n;
+		}
+		check(n == 1000 && component.frames().runs().size() == 2, "upFit() makes the last run longer");
+		component.frames().truncate(2);
+		check(component.getFrameNumber() == 2 && component.frames().at(1).empty(), "truncate() in the middle of a run");
+	}
+	std::cout << (failed == 0 ? "all passed\n" : "");
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,114 @@
+//  Manager, with both dispatch backends:
+//    g++ -std=c++17 -I.. manager.cpp -o manager && ./manager
+//  Prints the checks that fail, returns 1 if any does.
+
+#include <iostream>
+#include <memory>
+#include <type_traits>
+
+#include "../lexer.hpp"
+#include "../manager.hpp"
+
+namespace {
+	int failed = 0;
+
+	void check(const bool& ok, const char* what) {
+		if (!ok) {
+			std::cout << "failed: " << what << "\n";
+			++failed;
+		}
+	}
+
+	const char* const script =
+		"[name=\"Amiya\"]Doctor.\n"
+		"[Character(name=\"char_002_amiya\")]\n"
+		"[custom(key=\"value\")]\n";
+
+	template<typename Dispatch>
+	void testMove(const char* name) {
+		//  the tokens point into the Manager's storage, copies would share it
+		static_assert(!std::is_copy_constructible_v<arksp::BasicManager<Dispatch>>, "Manager can't be copied");
+		static_assert(!std::is_copy_assignable_v<arksp::BasicManager<Dispatch>>, "Manager can't be copied");
+		static_assert(std::is_move_constructible_v<arksp::BasicManager<Dispatch>>, "Manager can be moved");
+		static_assert(std::is_move_assignable_v<arksp::BasicManager<Dispatch>>, "Manager can be moved");
+
+		//  the moved-from Manager is destroyed before the other one is used
+		auto source = std::make_unique<arksp::BasicManager<Dispatch>>();
+		source->init(arksp::Lexer::lex(script));
+		arksp::BasicManager<Dispatch> manager(std::move(*source));
+		source.reset();
+		std::cout << name << "\n";
+		check(manager.getSize() == 3, "the moved Manager keeps the tokens");
+		check(std::get<arksp::Text>(manager[0]) == "Doctor.", "and their text");
+		check(std::get<arksp::Prop>(manager[1]).at(0).second == "char_002_amiya", "and their props");
+
+		std::size_t n = 0;
+		manager.connect("custom", [&n](ARKSP_SIGNAL_VIEW(tok)) { n += tok.propCount; });
+		manager.ptrRewind();
+		do {
+			manager.emitSignal();
+		} while (manager.ptrForward());
+		check(n == 1, "and emits them");
+
+		arksp::BasicManager<Dispatch> assigned;
+		assigned = std::move(manager);
+		check(assigned.getSize() == 3 && assigned.getTokenView().func == "custom", "move assignment keeps the tokens and the pointer");
+	}
+
+	template<typename Dispatch>
+	void testPatch() {
+		//  replace() and setNickname() keep their strings in the Manager, not in the Script
+		auto script = std::make_shared<const arksp::Script>(arksp::Lexer::lex(
+			"[name=\"Amiya\"]{@nickname}.\n"
+			"[Character(name=\"$who\")]\n"));
+		auto source = std::make_unique<arksp::BasicManager<Dispatch>>();
+		source->init(script);
+		source->setNickname("Doctor");
+		source->replace("{\"who\":\"char_002_amiya\"}");
+		arksp::BasicManager<Dispatch> manager(std::move(*source));
+		source.reset();
+		check(std::get<arksp::Text>(manager[0]) == "Doctor.", "a moved Manager keeps setNickname()");
+		check(std::get<arksp::Prop>(manager[1]).at(0).second == "char_002_amiya", "a moved Manager keeps replace()");
+
+		arksp::BasicManager<Dispatch> other;
+		other.init(script);
+		check(std::get<arksp::Text>(other[0]) == "{@nickname}." && std::get<arksp::Prop>(other[1]).at(0).second == "$who",
+			"a Manager sharing the Script doesn't see them");
+	}
+	//  replace() checks every $key first, a failed call changes nothing
+	void testReplaceFails() {
+		arksp::Manager manager;
+		manager.init(arksp::Lexer::lex(
+			"[Character(name=\"$first\")]\n"
+			"[Character(name=\"$second\", name2=\"$first\")]\n"));
+		auto failed = [&manager](const std::string& json) {
+			try {
+				manager.replace(json);
+			}
+			catch (std::string&) {
+				return true;
+			}
+			return false;
+		};
+		auto values = [&manager] {
+			auto a = std::get<arksp::Prop>(manager[0]), b = std::get<arksp::Prop>(manager[1]);
+			return a.at(0).second + "," + b.at(0).second + "," + b.at(1).second;
+		};
+		check(failed("{\"first\":\"a\"}"), "replace() without $second throws");
+		check(values() == "$first,$second,$first", "and replaces nothing, not even $first");
+		check(!failed("{\"first\":\"a\",\"second\":\"b\"}"), "replace() with both keys succeeds");
+		check(values() == "a,b,a", "and replaces all of them");
+		check(failed("{\"first\":"), "replace() with broken json throws");
+		check(values() == "a,b,a", "and keeps the earlier values");
+	}
+}
+
+int main() {
+	testMove<arksp::SignalsDispatch>("SignalsDispatch");
+	testMove<arksp::DirectDispatch>("DirectDispatch");
+	testPatch<arksp::SignalsDispatch>();
+	testPatch<arksp::DirectDispatch>();
+	testReplaceFails();
+	std::cout << (failed == 0 ? "all passed\n" : "");
+	return failed == 0 ? 0 : 1;
+}
@@ -2,89 +2,547 @@
 
 #ifdef ARKSP_CONTEXT
 #include <opencv2/core.hpp>
-#define ARKSP_COMP_PROC_TYPE(_List, _Prop) \
-	std::list<std::shared_ptr<cv::Mat>>* _List, \
+#define ARKSP_COMP_PROC_TYPE(_Frames, _Prop) \
+	arksp::FrameStore* _Frames, \
 	const std::vector<std::pair<std::string, std::string>>& _Prop
 #endif
 
 #include <vector>
-#include <list>
 #include <map>
 #include <utility>
 #include <functional>
+#include <deque>
+#include <unordered_map>
+#include <iterator>
+#include <stdexcept>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <cstdint>
 
 #include "core.hpp"
+#include "symbol.hpp"
 #include "manager.hpp"
 
 namespace arksp {
+	//  Interns the strings of an Environment: asset names, and the prop values
+	//  numbers are set from. A string that starts with a number is parsed
+	//  once here, as std::stof() does. ID 0 is the empty string.
+	class AssetTable {
+	public:
+		using idType = std::uint32_t;
+
+		AssetTable() {
+			intern("");
+		}
+		//  m_map points into m_storage
+		AssetTable(const AssetTable& other) {
+			for (auto& s : other.m_storage) {
+				intern(s.name);
+			}
+		}
+		AssetTable& operator=(const AssetTable& other) {
+			if (this != &other) {
+				AssetTable tmp(other);
+				m_map.swap(tmp.m_map);
+				m_storage.swap(tmp.m_storage);
+			}
+			return *this;
+		}
+		AssetTable(AssetTable&&) = default;
+		AssetTable& operator=(AssetTable&&) = default;
+
+		idType intern(std::string_view name) {
+			auto ite = m_map.find(name);
+			if (ite != m_map.end()) {
+				return ite->second;
+			}
+			auto id = static_cast<idType>(m_storage.size());
+			m_storage.push_back({ std::string(name),0.0f,false });
+			auto& s = m_storage.back();
+			char* end = nullptr;
+			s.number = std::strtof(s.name.c_str(), &end);
+			s.numeric = end != s.name.c_str();
+			m_map.emplace(s.name, id);
+			return id;
+		}
+		std::string_view name(const idType& id) const {
+			return id < m_storage.size() ? std::string_view(m_storage[id].name) : std::string_view();
+		}
+		//  whether name(id) starts with a number
+		bool numeric(const idType& id) const {
+			return id < m_storage.size() && m_storage[id].numeric;
+		}
+		//  throws std::invalid_argument as std::stof() if it isn't a number
+		float number(const idType& id) const {
+			if (!numeric(id)) {
+				throw std::invalid_argument("stof");
+			}
+			return m_storage[id].number;
+		}
+		std::size_t size() const {
+			return m_storage.size();
+		}
+
+	private:
+		struct Entry {
+			std::string name;
+			float number;
+			bool numeric;
+		};
+
+		std::unordered_map<std::string_view, idType> m_map;
+		std::deque<Entry> m_storage;  //  deque doesn't move its elements on push_back
+	};
+
+	//  A number of the state. text is the prop value it's set from, so that
+	//  EnvState shows it as it was written, or 0 if it's computed.
+	struct EnvNumber {
+		float value = 0.0f;
+		arksp::AssetTable::idType text = 0;
+
+		bool operator==(const EnvNumber& other) const {
+			return value == other.value && text == other.text;
+		}
+		bool operator!=(const EnvNumber& other) const {
+			return !(*this == other);
+		}
+	};
+
+	//  The state of an Environment at a block, with the fields EnvState has as
+	//  strings. Names are IDs of Environment::assets(), 0 is empty.
+	struct EnvData {
+		arksp::AssetTable::idType middle = 0;
+		arksp::AssetTable::idType left = 0;
+		arksp::AssetTable::idType right = 0;
+		arksp::AssetTable::idType background = 0;
+		arksp::EnvNumber bg_xscale;
+		arksp::EnvNumber bg_yscale;
+		arksp::EnvNumber bg_x;
+		arksp::EnvNumber bg_y;
+		arksp::AssetTable::idType image = 0;
+		arksp::EnvNumber image_xScale;
+		arksp::EnvNumber image_yScale;
+		arksp::EnvNumber image_x;
+		arksp::EnvNumber image_y;
+		arksp::EnvNumber first_xpos;
+		arksp::EnvNumber first_ypos;
+		arksp::EnvNumber second_xpos;
+		arksp::EnvNumber second_ypos;
+		arksp::EnvNumber middle_xpos;
+		arksp::EnvNumber middle_ypos;
+	};
+
+	//  The states of an Environment, one per block. Most blocks change a few
+	//  fields, so only every interval-th state is kept whole (a keyframe),
+	//  the others as the 32-bit words of EnvData that changed since the
+	//  state before. at() starts from the keyframe and applies the changes.
+	class EnvHistory {
+	public:
+		using sizeType = std::vector<std::uint64_t>::size_type;
+
+		explicit EnvHistory(const sizeType& interval = 32) : m_interval(std::max<sizeType>(interval, 1)) {}
+
+		void push_back(const arksp::EnvData& data) {
+			if (m_masks.size() % m_interval == 0) {
+				m_keys.push_back(data);
+				m_keyWords.push_back(static_cast<std::uint32_t>(m_words.size()));
+				m_masks.push_back(0);
+			}
+			else {
+				std::uint32_t last[Words], now[Words];
+				std::memcpy(last, &m_last, sizeof(last));
+				std::memcpy(now, &data, sizeof(now));
+				std::uint64_t mask = 0;
+				for (std::size_t i = 0; i < Words; ++i) {
+					if (now[i] != last[i]) {
+						mask |= std::uint64_t(1) << i;
+						m_words.push_back(now[i]);
+					}
+				}
+				m_masks.push_back(mask);
+			}
+			m_last = data;
+		}
+
+		//  throws std::string if index is out of range
+		arksp::EnvData at(const sizeType& index) const {
+			if (index >= m_masks.size()) {
+				throw std::string("Error: out of index in Env list");
+			}
+			const sizeType key = index / m_interval;
+			std::uint32_t words[Words];
+			std::memcpy(words, &m_keys[key], sizeof(words));
+			const std::uint32_t* value = m_words.data() + m_keyWords[key];
+			for (sizeType i = key * m_interval + 1; i <= index; ++i) {
+				for (std::uint64_t mask = m_masks[i]; mask != 0; mask &= mask - 1) {
+					words[lowestBit(mask)] = *value++;
+				}
+			}
+			arksp::EnvData ret;
+			std::memcpy(&ret, words, sizeof(words));
+			return ret;
+		}
+		//  Drops the states from index count on.
+		void truncate(const sizeType& count) {
+			if (count >= m_masks.size()) {
+				return;
+			}
+			assign(*this, count);
+		}
+		//  The first count states of other, which is this or a history the
+		//  states here are the first ones of.
+		void assign(const EnvHistory& other, const sizeType& count) {
+			if (count > other.m_masks.size()) {
+				throw std::string("Error: out of index in Env list");
+			}
+			const sizeType keys = count == 0 ? 0 : (count - 1) / other.m_interval + 1;
+			std::size_t words = 0;
+			if (count != 0) {
+				words = other.m_keyWords[keys - 1];
+				for (sizeType i = (keys - 1) * other.m_interval + 1; i < count; ++i) {
+					words += popCount(other.m_masks[i]);
+				}
+			}
+			if (this != &other) {
+				m_interval = other.m_interval;
+				m_keys.assign(other.m_keys.begin(), other.m_keys.begin() + keys);
+				m_keyWords.assign(other.m_keyWords.begin(), other.m_keyWords.begin() + keys);
+				m_masks.assign(other.m_masks.begin(), other.m_masks.begin() + count);
+				m_words.assign(other.m_words.begin(), other.m_words.begin() + words);
+			}
+			else {
+				m_keys.resize(keys);
+				m_keyWords.resize(keys);
+				m_masks.resize(count);
+				m_words.resize(words);
+			}
+			if (count != 0) {
+				m_last = at(count - 1);
+			}
+		}
+
+		const arksp::EnvData& back() const {
+			return m_last;
+		}
+		sizeType size() const {
+			return m_masks.size();
+		}
+		bool empty() const {
+			return m_masks.empty();
+		}
+		sizeType interval() const {
+			return m_interval;
+		}
+		//  bytes of the arrays, to compare with size() * sizeof(EnvData)
+		std::size_t memory() const {
+			return m_keys.capacity() * sizeof(arksp::EnvData) + m_keyWords.capacity() * sizeof(std::uint32_t)
+				+ m_masks.capacity() * sizeof(std::uint64_t) + m_words.capacity() * sizeof(std::uint32_t);
+		}
+
+	private:
+		static constexpr std::size_t Words = sizeof(arksp::EnvData) / sizeof(std::uint32_t);
+		static_assert(std::is_trivially_copyable<arksp::EnvData>::value && sizeof(arksp::EnvData) % sizeof(std::uint32_t) == 0,
+			"arksp: EnvData must be plain 32-bit words");
+		static_assert(Words <= 64, "arksp: a mask of EnvHistory has 64 bits");
+
+		static inline unsigned int lowestBit(const std::uint64_t& mask) {
+#if defined(__GNUC__) || defined(__clang__)
+			return static_cast<unsigned int>(__builtin_ctzll(mask));
+#else
+			unsigned int ret = 0;
+			while ((mask >> ret & 1) == 0) {
+				++ret;
+			}
+			return ret;
+#endif
+		}
+
+		static inline std::size_t popCount(std::uint64_t mask) {
+			std::size_t ret = 0;
+			for (; mask != 0; mask &= mask - 1) {
+				++ret;
+			}
+			return ret;
+		}
+
+		std::vector<arksp::EnvData> m_keys;
+		std::vector<std::uint32_t> m_keyWords;  //  where the changes after each keyframe start in m_words
+		std::vector<std::uint64_t> m_masks;  //  of each state, 0 for a keyframe
+		std::vector<std::uint32_t> m_words;
+		arksp::EnvData m_last;
+		sizeType m_interval;
+	};
+
 #ifdef ARKSP_CONTEXT
-	class Component {
+	//  The frames of a Component, as runs of one cv::Mat repeated count
+	//  times. Holding a frame makes its run longer instead of adding frames,
+	//  and the cv::Mat of dropped runs are kept to be reused by acquire()
+	//  if nothing else shares their buffer.
+	//  The frames of a run are the same cv::Mat, writing one writes them all.
+	class FrameStore {
 	public:
-		Component() {}
+		using sizeType = std::size_t;
 
-		void upFit(const unsigned long& maxFrame) {
-			if (getFrameNumber() >= maxFrame) {
+		//  the frames [end - count, end)
+		struct Run {
+			cv::Mat mat;
+			sizeType count;
+			sizeType end;
+		};
+
+		//  Goes over the frames one by one, each frame of a run is its cv::Mat.
+		template<bool Const>
+		class basic_iterator {
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = cv::Mat;
+			using difference_type = std::ptrdiff_t;
+			using pointer = std::conditional_t<Const, const cv::Mat*, cv::Mat*>;
+			using reference = std::conditional_t<Const, const cv::Mat&, cv::Mat&>;
+			using ownerType = std::conditional_t<Const, const FrameStore*, FrameStore*>;
+
+			basic_iterator() {}
+			basic_iterator(ownerType store, const sizeType& run, const sizeType& offset)
+				: m_store(store), m_run(run), m_offset(offset) {}
+			//  iterator to const_iterator
+			operator basic_iterator<true>() const {
+				return basic_iterator<true>(m_store, m_run, m_offset);
+			}
+
+			reference operator*() const {
+				return m_store->m_vecRun[m_run].mat;
+			}
+			pointer operator->() const {
+				return &**this;
+			}
+			basic_iterator& operator++() {
+				if (++m_offset == m_store->m_vecRun[m_run].count) {
+					++m_run;
+					m_offset = 0;
+				}
+				return *this;
+			}
+			basic_iterator operator++(int) {
+				auto ret = *this;
+				++*this;
+				return ret;
+			}
+			bool operator==(const basic_iterator& other) const {
+				return m_store == other.m_store && m_run == other.m_run && m_offset == other.m_offset;
+			}
+			bool operator!=(const basic_iterator& other) const {
+				return !(*this == other);
+			}
+
+		private:
+			ownerType m_store = nullptr;
+			sizeType m_run = 0;
+			sizeType m_offset = 0;  //  in the run
+		};
+		typedef basic_iterator<false> iterator;
+		typedef basic_iterator<true> const_iterator;
+
+		//  A cv::Mat of rows x cols of type for a new frame. The buffer of a
+		//  dropped run is reused if there is one, cv::Mat::create() keeps it
+		//  when it's already that size and type.
+		cv::Mat acquire(const int& rows, const int& cols, const int& type) {
+			cv::Mat ret;
+			if (!m_vecPool.empty()) {
+				ret = std::move(m_vecPool.back());
+				m_vecPool.pop_back();
+			}
+			ret.create(rows, cols, type);
+			return ret;
+		}
+
+		//  appends mat as count frames
+		void push_back(cv::Mat mat, const sizeType& count = 1) {
+			if (count == 0) {
 				return;
 			}
-			else if (getFrameNumber() == 0) {
-				m_listMat.resize(maxFrame);
+			m_vecRun.push_back({ std::move(mat),count,size() + count });
+		}
+		//  Appends count frames of the last frame, or of an empty cv::Mat if
+		//  there is none.
+		void hold(const sizeType& count) {
+			if (count == 0) {
 				return;
 			}
-			else {
-				iterator ite = m_listMat.end();
-				--ite;
-				m_listMat.push_back(*ite);
-				upFit(maxFrame);
+			if (m_vecRun.empty()) {
+				push_back(cv::Mat(), count);
+				return;
+			}
+			m_vecRun.back().count += count;
+			m_vecRun.back().end += count;
+		}
+		//  drops the frames from count on
+		void truncate(const sizeType& count) {
+			if (count >= size()) {
+				return;
+			}
+			auto run = runAt(count);
+			if (count > m_vecRun[run].end - m_vecRun[run].count) {
+				m_vecRun[run].count -= m_vecRun[run].end - count;
+				m_vecRun[run].end = count;
+				++run;
 			}
+			//  from the back, so of two runs of one buffer the first is its only owner
+			for (auto i = m_vecRun.size(); i-- > run;) {
+				if (soleOwner(m_vecRun[i].mat)) {
+					m_vecPool.push_back(std::move(m_vecRun[i].mat));
+				}
+				else {
+					m_vecRun[i].mat.release();
+				}
+			}
+			m_vecRun.erase(m_vecRun.begin() + run, m_vecRun.end());
+		}
+		void clear() {
+			truncate(0);
 		}
 
-		void process(const std::function<void(ARKSP_COMP_PROC_TYPE())>& ProcessFunction,
+		//  the frame at index, a binary search over the runs
+		cv::Mat& operator[](const sizeType& index) {
+			return m_vecRun[runAt(index)].mat;
+		}
+		const cv::Mat& operator[](const sizeType& index) const {
+			return m_vecRun[runAt(index)].mat;
+		}
+		cv::Mat& at(const sizeType& index) {
+			if (index >= size()) {
+				throw std::string("Error: Out of index");
+			}
+			return (*this)[index];
+		}
+		const cv::Mat& at(const sizeType& index) const {
+			if (index >= size()) {
+				throw std::string("Error: Out of index");
+			}
+			return (*this)[index];
+		}
+
+		//  the number of frames, not of runs
+		sizeType size() const {
+			return m_vecRun.empty() ? 0 : m_vecRun.back().end;
+		}
+		bool empty() const {
+			return m_vecRun.empty();
+		}
+		const std::vector<Run>& runs() const {
+			return m_vecRun;
+		}
+		//  the cv::Mat waiting in the pool
+		sizeType pooled() const {
+			return m_vecPool.size();
+		}
+
+		iterator begin() {
+			return iterator(this, 0, 0);
+		}
+		iterator end() {
+			return iterator(this, m_vecRun.size(), 0);
+		}
+		const_iterator begin() const {
+			return const_iterator(this, 0, 0);
+		}
+		const_iterator end() const {
+			return const_iterator(this, m_vecRun.size(), 0);
+		}
+
+	private:
+		//  A cv::Mat copy shares the buffer, one that a kept run or the caller
+		//  still has can't be handed out again by acquire().
+		static bool soleOwner(const cv::Mat& mat) {
+			return mat.u != nullptr && mat.u->refcount == 1;
+		}
+		//  the run of the frame index, index < size()
+		sizeType runAt(const sizeType& index) const {
+			auto ite = std::upper_bound(m_vecRun.begin(), m_vecRun.end(), index, [](const sizeType& i, const Run& run) {
+				return i < run.end;
+			});
+			return static_cast<sizeType>(ite - m_vecRun.begin());
+		}
+
+		std::vector<Run> m_vecRun;
+		std::vector<cv::Mat> m_vecPool;
+	};
+
+	class Component {
+	public:
+		Component() {}
+
+		//  Holds the last frame until there are maxFrame frames, an empty
+		//  Component gets maxFrame empty frames.
+		void upFit(const unsigned long& maxFrame) {
+			if (getFrameNumber() < maxFrame) {
+				m_frames.hold(maxFrame - getFrameNumber());
+			}
+		}
+
+		void process(const std::function<void(ARKSP_COMP_PROC_TYPE(,))>& ProcessFunction,
 			const std::vector<std::pair<std::string, std::string>>& prop) {
-			ProcessFunction(&m_listMat, prop);
+			ProcessFunction(&m_frames, prop);
 		}
-		void process(std::function<void(ARKSP_COMP_PROC_TYPE())>&& ProcessFunction,
+		void process(std::function<void(ARKSP_COMP_PROC_TYPE(,))>&& ProcessFunction,
 			const std::vector<std::pair<std::string, std::string>>& prop) {
-			ProcessFunction(&m_listMat, prop);
+			ProcessFunction(&m_frames, prop);
 		}
 
-		typedef std::list<std::shared_ptr<cv::Mat>>::iterator iterator;
+		typedef arksp::FrameStore::iterator iterator;
 		unsigned long getFrameNumber() {
-			return m_listMat.size();
+			return static_cast<unsigned long>(m_frames.size());
 		}
 		auto empty() {
-			return m_listMat.empty();
+			return m_frames.empty();
 		}
 		iterator begin() {
-			return m_listMat.begin();
+			return m_frames.begin();
 		}
 		iterator end() {
-			return m_listMat.end();
+			return m_frames.end();
+		}
+		arksp::FrameStore& frames() {
+			return m_frames;
 		}
 
 	private:
-		std::list<std::shared_ptr<cv::Mat>> m_listMat;
+		arksp::FrameStore m_frames;
 	};
 
 	class Context {
 	public:
 		typedef std::pair<std::string, std::vector<std::pair<std::string, std::string>>> FuncType;
 		
-		Context(std::vector<std::vector<std::pair<std::string, std::string>>>* env) {
+		Context(arksp::EnvHistory* env) {
 			m_env = env;
 		}
 
 		void setFunc(const FuncType& func) {
 			m_vecFunc.push_back(func);
 		}
+		std::size_t funcCount() const {
+			return m_vecFunc.size();
+		}
+		//  keeps the first count funcs, for Environment::restore()
+		void truncate(const std::size_t& count) {
+			if (count < m_vecFunc.size()) {
+				m_vecFunc.resize(count);
+			}
+		}
 
-		static Context create(std::vector<std::vector<std::pair<std::string,std::string>>>* env) {
+		static Context create(arksp::EnvHistory* env) {
 			return Context(env);
 		}
 
 	private:
 		Context() {}
 		std::vector<FuncType> m_vecFunc;
-		std::vector<std::vector<std::pair<std::string, std::string>>>* m_env = nullptr;
+		arksp::EnvHistory* m_env = nullptr;
 
 		static inline auto getProp(const std::string& func,
 			std::vector<FuncType>& vecFunc) {
@@ -106,7 +564,65 @@ namespace arksp {
 		typedef std::vector<std::pair<std::string, std::string>> EnvState;
 		typedef std::vector<std::pair<std::string, std::string>> PropType;
 
-		Environment() {
+		//  Goes over the states as EnvState, which are made when they are read.
+		class const_iterator {
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = EnvState;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const EnvState*;
+			using reference = const EnvState&;
+
+			const_iterator(const Environment* env, const arksp::EnvHistory::sizeType& index)
+				: m_owner(env), m_index(index) {}
+
+			reference operator*() const {
+				m_cache = m_owner->toEnvState(m_owner->m_env.at(m_index));
+				return m_cache;
+			}
+			pointer operator->() const {
+				return &**this;
+			}
+			const_iterator& operator++() {
+				++m_index;
+				return *this;
+			}
+			const_iterator operator++(int) {
+				auto ret = *this;
+				++m_index;
+				return ret;
+			}
+			bool operator==(const const_iterator& other) const {
+				return m_owner == other.m_owner && m_index == other.m_index;
+			}
+			bool operator!=(const const_iterator& other) const {
+				return !(*this == other);
+			}
+
+		private:
+			const Environment* m_owner;
+			arksp::EnvHistory::sizeType m_index;
+			mutable EnvState m_cache;
+		};
+
+		//  every keyframe-th state is kept whole, see EnvHistory
+		explicit Environment(const std::size_t& keyframe = 32) : m_env(keyframe) {
+			m_zero = literal("0");
+			current.background = m_assets.intern("default");
+			current.bg_xscale = literal("1");
+			current.bg_yscale = literal("1");
+			current.bg_x = m_zero;
+			current.bg_y = m_zero;
+			current.image_xScale = literal("1");
+			current.image_yScale = literal("1");
+			current.image_x = m_zero;
+			current.image_y = m_zero;
+			current.first_xpos = m_zero;
+			current.first_ypos = m_zero;
+			current.second_xpos = m_zero;
+			current.second_ypos = m_zero;
+			current.middle_xpos = m_zero;
+			current.middle_ypos = m_zero;
 			m_env.push_back(current);
 #ifdef ARKSP_CONTEXT
 			m_ctx.push_back(Context::create(&m_env));
@@ -114,183 +630,65 @@ namespace arksp {
 		}
 
 		void slotRead(ARKSP_SIGNAL_GLOBAL(func, text, prop)) {
-			auto _ite2 = m_env.end() - 1;
-			if (func == "background") {
-				setEnv(func, arksp::Manager::getValueByPropName("image", prop), current);
-				if (arksp::Manager::getValueByPropName("xscale", prop) != "") {
-					setEnv("bg_xscale", arksp::Manager::getValueByPropName("xscale", prop), current);
-				}
-				else {
-					setEnv("bg_xscale", "0", current);
-				}
-				if (arksp::Manager::getValueByPropName("yscale", prop) != "") {
-					setEnv("bg_yscale", arksp::Manager::getValueByPropName("yscale", prop), current);
-				}
-				else {
-					setEnv("bg_yscale", "0", current);
-				}
-				if (arksp::Manager::getValueByPropName("y", prop) != "") {
-					setEnv("bg_y", arksp::Manager::getValueByPropName("y", prop), current);
-				}
-				else {
-					setEnv("bg_y", "0", current);
-				}
-				if (arksp::Manager::getValueByPropName("x", prop) != "") {
-					setEnv("bg_x", arksp::Manager::getValueByPropName("x", prop), current);
-				}
-				else {
-					setEnv("bg_x", "0", current);
-				}
-			}
-			else if (func == "backgroundtween") {
-				auto _yTo = arksp::Manager::getValueByPropName("yTo", prop);
-				auto _xTo = arksp::Manager::getValueByPropName("xTo", prop);
-				if (_yTo != "") {
-					auto fin = std::to_string(std::stof(_yTo) + std::stof(getValueOfEnv("bg_y", current)));
-					setEnv("bg_y", fin, current);
-				}
-				if (_xTo != "") {
-					auto fin = std::to_string(std::stof(_xTo) + std::stof(getValueOfEnv("bg_x", current)));
-					setEnv("bg_x", fin, current);
-				}
-			}
-			else if (func == "character") {
-				//  character() means clear
-				if (arksp::Manager::getValueByPropName("name", prop) == "") {
-					setEnv("middle", "", current);
-					setEnv("left", "", current);
-					setEnv("right", "", current);
-					setEnv("middle_xpos", "0", current);
-					setEnv("middle_ypos", "0", current);
-					setEnv("first_xpos", "0", current);
-					setEnv("first_ypos", "0", current);
-					setEnv("second_xpos", "0", current);
-					setEnv("second_ypos", "0", current);
-				}
-				else if (arksp::Manager::getValueByPropName("name2", prop) == "") {
-					setEnv("middle", arksp::Manager::getValueByPropName("name", prop), current);
-					//  it's clearly that if B only has name, A should be cleaned
-					setEnv("first_xpos", "0", current);
-					setEnv("first_ypos", "0", current);
-					setEnv("second_xpos", "0", current);
-					setEnv("second_ypos", "0", current);
-					setEnv("left", "", current);
-					setEnv("right", "", current);
-				}
-				else {
-					//  if B has name and name2, but A only has name, then clean the state
-					if (!getValueOfEnv("middle", *_ite2).empty()) {
-						setEnv("middle_xpos", "0", current);
-						setEnv("middle_ypos", "0", current);
-						setEnv("first_xpos", "0", current);
-						setEnv("first_ypos", "0", current);
-						setEnv("second_xpos", "0", current);
-						setEnv("second_ypos", "0", current);
-					}
-
-					setEnv("middle", "", current);
-					setEnv("left", arksp::Manager::getValueByPropName("name", prop), current);
-					setEnv("right", arksp::Manager::getValueByPropName("name2", prop), current);
-				}
+			arksp::token_view tok;
+			tok.func = func;
+			tok.funcId = arksp::commandOf(func);
+			tok.text = text;
+			m_vecProp.clear();
+			for (auto& s : prop) {
+				m_vecProp.push_back({ s.first,s.second,arksp::propKeyOf(s.first) });
 			}
-			else if (func == "characteraction") {
-				auto type = arksp::Manager::getValueByPropName("type", prop);
-				auto xpos = arksp::Manager::getValueByPropName("xpos", prop);
-				auto ypos = arksp::Manager::getValueByPropName("ypos", prop);
-				if (arksp::Manager::getValueByPropName("name", prop) == "left") {
-					if (type == "exit") {
-						if (arksp::Manager::getValueByPropName("direction", prop) == "left") {
-							setEnv("first_xpos", "-4000", current);
-						}
-						else {
-							setEnv("first_xpos", "4000", current);
-						}
-					}
-					else {
-						if (!xpos.empty()) {
-							auto f = std::stof(xpos) + std::stof(getValueOfEnv("first_xpos", *_ite2));
-							setEnv("first_xpos", std::to_string(f), current);
-						}
-						if (!ypos.empty()) {
-							auto f = std::stof(ypos) + std::stof(getValueOfEnv("first_ypos", *_ite2));
-							setEnv("first_ypos", std::to_string(f), current);
-						}
-					}
-				}
-				else {
-					if (type == "exit") {
-						if (arksp::Manager::getValueByPropName("direction", prop) == "left") {
-							setEnv("second_xpos", "-2000", current);
-						}
-						else {
-							setEnv("second_xpos", "2000", current);
-						}
-					}
-					else {
-						if (!xpos.empty()) {
-							auto f = std::stof(xpos) + std::stof(getValueOfEnv("second_xpos", *_ite2));
-							setEnv("second_xpos", std::to_string(f), current);
-						}
-						if (!ypos.empty()) {
-							auto f = std::stof(ypos) + std::stof(getValueOfEnv("second_ypos", *_ite2));
-							setEnv("second_ypos", std::to_string(f), current);
-						}
+			tok.props = m_vecProp.data();
+			tok.propCount = static_cast<std::uint32_t>(m_vecProp.size());
+			slotReadView(tok);
+		}
+		//  The same as slotRead(), connect it as an ARKSP_SIGNAL_VIEW slot.
+		//  The props are looked up by their interned keys, nothing is copied
+		//  to read them.
+		void slotReadView(ARKSP_SIGNAL_VIEW(tok)) {
+			const arksp::EnvData& last = m_env.back();
+			bool block = false;
+			//  The builtin commands are a switch on the ID, the compiler makes it a
+			//  jump table and inlines the read functions. Only the other commands
+			//  are looked up in m_mapHandler.
+			switch (tok.funcId) {
+			case arksp::Command::Background:
+				readBackground(tok);
+				break;
+			case arksp::Command::BackgroundTween:
+				readBackgroundTween(tok);
+				break;
+			case arksp::Command::Character:
+				readCharacter(tok, last);
+				break;
+			case arksp::Command::CharacterAction:
+				readCharacterAction(tok, last);
+				break;
+			case arksp::Command::Image:
+				readImage(tok);
+				break;
+			case arksp::Command::ImageTween:
+				readImageTween(tok);
+				break;
+			case arksp::Command::Delay:
+				block = true;  //  every delay saves a state
+				break;
+			default:
+				if ((tok.funcId == arksp::Command::Unknown || tok.funcId >= arksp::Command::Count) && !m_mapHandler.empty()) {
+					auto ite = m_mapHandler.find(tok.func);
+					if (ite != m_mapHandler.end()) {
+						ite->second.first(*this, tok);
+						block = ite->second.second;
 					}
 				}
-			}
-			else if (func == "image") {
-				setEnv(func, arksp::Manager::getValueByPropName("image", prop), current);
-				if (arksp::Manager::getValueByPropName("xScale", prop) != "") {
-					setEnv("image_xScale", arksp::Manager::getValueByPropName("xScale", prop), current);
-				}
-				else {
-					setEnv("image_xScale", "0", current);
-				}
-				if (arksp::Manager::getValueByPropName("yScale", prop) != "") {
-					setEnv("image_yScale", arksp::Manager::getValueByPropName("yScale", prop), current);
-				}
-				else {
-					setEnv("image_yScale", "0", current);
-				}
-				if (arksp::Manager::getValueByPropName("y", prop) != "") {
-					setEnv("image_y", arksp::Manager::getValueByPropName("y", prop), current);
-				}
-				else {
-					setEnv("image_y", "0", current);
-				}
-				if (arksp::Manager::getValueByPropName("x", prop) != "") {
-					setEnv("image_x", arksp::Manager::getValueByPropName("x", prop), current);
-				}
-				else {
-					setEnv("image_x", "0", current);
-				}				
-			}
-			else if (func == "imagetween") {
-				auto _yTo = arksp::Manager::getValueByPropName("yTo", prop);
-				auto _xTo = arksp::Manager::getValueByPropName("xTo", prop);
-				auto _xScale = arksp::Manager::getValueByPropName("xScaleTo", prop);
-				auto _yScale = arksp::Manager::getValueByPropName("yScaleTo", prop);
-				if (_yTo != "") {
-					auto fin = std::to_string(std::stof(_yTo) + std::stof(getValueOfEnv("bg_y", current)));
-					setEnv("image_y", fin, current);
-				}
-				if (_xTo != "") {
-					auto fin = std::to_string(std::stof(_xTo) + std::stof(getValueOfEnv("bg_x", current)));
-					setEnv("image_x", fin, current);
-				}
-				if (_xScale != "") {
-					setEnv("image_xScale", _xScale, current);
-				}
-				if (_yScale != "") {
-					setEnv("image_yScale", _yScale, current);
-				}
+				break;
 			}
 
 #ifdef ARKSP_CONTEXT
 			auto _ite = m_ctx.end() - 1;
-			_ite->setFunc({ func,prop });
+			_ite->setFunc({ std::string(tok.func),std::get<arksp::Prop>(tok.toToken()) });
 #endif
-			if (func == "delay" || arksp::Manager::getValueByPropName("block", prop) == "true") {
+			if (block || (tok.propCount != 0 && valueOr(tok, arksp::PropKey::Block, "") == "true")) {
 #ifdef ARKSP_CONTEXT
 				m_ctx.push_back(Context::create(&m_env));
 #endif
@@ -298,13 +696,149 @@ namespace arksp {
 			}
 		}
 
-		EnvState* getContext(std::vector<EnvState>::size_type index) {
-			auto ite = m_env.begin() + index;
-			if (ite >= m_env.end() || ite < m_env.begin()) {
+		//  Reads the tokens of a command the library doesn't know. handler can
+		//  change the state through getCurrent() and assets(), history().back()
+		//  is the state before the token. If block, every token of the command
+		//  saves a state, as delay() does. The commands of Command have their
+		//  handlers built in and can't be set, false is returned for them.
+		typedef std::function<void(arksp::Environment&, ARKSP_SIGNAL_VIEW(tok))> Handler;
+		bool setHandler(const std::string& func_name, Handler handler, const bool& block = false) {
+			if (arksp::commandOf(func_name) != arksp::Command::Unknown) {
+				return false;
+			}
+			m_mapHandler[func_name] = { std::move(handler),block };
+			return true;
+		}
+		bool removeHandler(const std::string& func_name) {
+			return m_mapHandler.erase(func_name) != 0;
+		}
+
+		//  What reading the tokens after a point depends on, see save().
+		struct Snapshot {
+			arksp::EnvData current;
+			arksp::EnvHistory::sizeType states = 0;
+#ifdef ARKSP_CONTEXT
+			std::size_t funcs = 0;  //  of the last Context
+#endif
+		};
+		//  After restore(save()), reading the same tokens again gives the same
+		//  states. The states saved after the snapshot are dropped, the names
+		//  interned since then are kept. To restore a snapshot saved after the
+		//  states this has now, give the history it was saved in.
+		Snapshot save() const {
+			Snapshot ret;
+			ret.current = current;
+			ret.states = m_env.size();
+#ifdef ARKSP_CONTEXT
+			ret.funcs = m_ctx.back().funcCount();
+#endif
+			return ret;
+		}
+		void restore(const Snapshot& snapshot) {
+			restore(snapshot, m_env);
+		}
+		void restore(const Snapshot& snapshot, const arksp::EnvHistory& history) {
+			if (snapshot.states == 0 || snapshot.states > history.size()) {
 				throw std::string("Error: out of index in Env list");
-				return nullptr;
 			}
-			return &(*ite);
+			if (snapshot.states <= m_env.size()) {
+				m_env.truncate(snapshot.states);
+				for (auto ite = m_mapView.begin(); ite != m_mapView.end();) {
+					ite = ite->first >= snapshot.states ? m_mapView.erase(ite) : std::next(ite);
+				}
+			}
+			else {
+				m_env.assign(history, snapshot.states);
+				m_mapView.clear();
+			}
+#ifdef ARKSP_CONTEXT
+			m_ctx.resize(snapshot.states, Context::create(&m_env));
+			m_ctx.back().truncate(snapshot.funcs);
+#endif
+			current = snapshot.current;
+		}
+		//  the state after the tokens read so far
+		const arksp::EnvData& getCurrent() const {
+			return current;
+		}
+		arksp::EnvData& getCurrent() {
+			return current;
+		}
+
+		//  Reads every token of stream, without going through a Manager.
+		//  Returns the number of tokens read.
+		std::size_t readStream(arksp::TokenStream& stream) {
+			std::size_t ret = 0;
+			arksp::token_view tok;
+			while (stream.next(tok)) {
+				slotReadView(tok);
+				++ret;
+			}
+			return ret;
+		}
+
+		//  the state at index as EnvState, made from its EnvData on each call
+		EnvState getEnvState(arksp::EnvHistory::sizeType index) const {
+			return toEnvState(getState(index));
+		}
+		//  Each index gets its own EnvState, made on the first call and kept
+		//  until restore() drops or replaces the state. It's a copy, writing
+		//  to it doesn't change the state slotRead() goes on from.
+		[[deprecated("use getEnvState(), the state is kept as EnvData")]]
+		EnvState* getContext(std::vector<EnvState>::size_type index) {
+			auto ite = m_mapView.find(index);
+			if (ite == m_mapView.end()) {
+				ite = m_mapView.emplace(index, getEnvState(index)).first;
+			}
+			return &ite->second;
+		}
+		arksp::EnvData getState(arksp::EnvHistory::sizeType index) const {
+			return m_env.at(index);
+		}
+		arksp::EnvHistory::sizeType getStateCount() const {
+			return m_env.size();
+		}
+		const arksp::EnvHistory& history() const {
+			return m_env;
+		}
+		//  names of the IDs in EnvData
+		const arksp::AssetTable& assets() const {
+			return m_assets;
+		}
+		arksp::AssetTable& assets() {
+			return m_assets;
+		}
+
+		//  the string view of a state, the same keys in the same order as before
+		EnvState toEnvState(const arksp::EnvData& data) const {
+			EnvState ret;
+			ret.reserve(19);
+			auto name = [&](const char* key, const arksp::AssetTable::idType& id) {
+				ret.push_back({ key,std::string(m_assets.name(id)) });
+			};
+			auto number = [&](const char* key, const arksp::EnvNumber& n) {
+				ret.push_back({ key,n.text != 0 ? std::string(m_assets.name(n.text)) : std::to_string(n.value) });
+			};
+			name("middle", data.middle);
+			name("left", data.left);
+			name("right", data.right);
+			name("background", data.background);
+			number("bg_xscale", data.bg_xscale);
+			number("bg_yscale", data.bg_yscale);
+			number("bg_x", data.bg_x);
+			number("bg_y", data.bg_y);
+			name("image", data.image);
+			number("image_xScale", data.image_xScale);
+			number("image_yScale", data.image_yScale);
+			number("image_x", data.image_x);
+			number("image_y", data.image_y);
+			number("first_xpos", data.first_xpos);
+			number("first_ypos", data.first_ypos);
+			number("second_xpos", data.second_xpos);
+			number("second_ypos", data.second_ypos);
+			number("middle_xpos", data.middle_xpos);
+			number("middle_ypos", data.middle_ypos);
+			return ret;
 		}
 
 		static inline std::string getValueOfEnv(const std::string& key, const EnvState& env) {
@@ -318,8 +852,8 @@ namespace arksp {
 				return std::string();
 			}
 		}
-		static inline void setEnv(const std::string& key,
-			const std::string& value,
+		static inline void setEnv(std::string_view key,
+			std::string_view value,
 			EnvState& env) {
 			auto _ite = std::find_if(env.begin(), env.end(), [&](const auto& p) {
 				return p.first == key;
@@ -328,12 +862,12 @@ namespace arksp {
 				_ite->second = value;
 			}
 			else {
-				env.push_back({ key,value });
+				env.push_back({ std::string(key),std::string(value) });
 			}
 		}
 
 #ifdef ARKSP_DEBUG
-		std::vector<EnvState> m_env;
+		arksp::EnvHistory m_env;
 #ifdef ARKSP_CONTEXT
 		std::vector<Context> m_ctx;
 		auto begin() {
@@ -346,39 +880,254 @@ namespace arksp {
 #endif
 
 #ifndef ARKSP_CONTEXT
-		auto begin() {
-			return m_env.begin();
+		const_iterator begin() const {
+			return const_iterator(this, 0);
 		}
-		auto end() {
-			return m_env.end();
+		const_iterator end() const {
+			return const_iterator(this, m_env.size());
 		}
 #endif
 
 	private:
+		void readBackground(const arksp::token_view& tok) {
+			current.background = m_assets.intern(valueOr(tok, arksp::PropKey::Image, ""));
+			current.bg_xscale = literal(valueOr(tok, arksp::PropKey::Xscale, "0"));
+			current.bg_yscale = literal(valueOr(tok, arksp::PropKey::Yscale, "0"));
+			current.bg_y = literal(valueOr(tok, arksp::PropKey::Y, "0"));
+			current.bg_x = literal(valueOr(tok, arksp::PropKey::X, "0"));
+		}
+		void readBackgroundTween(const arksp::token_view& tok) {
+			auto _yTo = valueOr(tok, arksp::PropKey::YTo, "");
+			auto _xTo = valueOr(tok, arksp::PropKey::XTo, "");
+			if (_yTo != "") {
+				current.bg_y = computed(numberOf(literal(_yTo)) + numberOf(current.bg_y));
+			}
+			if (_xTo != "") {
+				current.bg_x = computed(numberOf(literal(_xTo)) + numberOf(current.bg_x));
+			}
+		}
+		void readCharacter(const arksp::token_view& tok, const arksp::EnvData& last) {
+			auto name = valueOr(tok, arksp::PropKey::Name, "");
+			auto name2 = valueOr(tok, arksp::PropKey::Name2, "");
+			//  character() means clear
+			if (name == "") {
+				current.middle = 0;
+				current.left = 0;
+				current.right = 0;
+				current.middle_xpos = m_zero;
+				current.middle_ypos = m_zero;
+				current.first_xpos = m_zero;
+				current.first_ypos = m_zero;
+				current.second_xpos = m_zero;
+				current.second_ypos = m_zero;
+			}
+			else if (name2 == "") {
+				current.middle = m_assets.intern(name);
+				//  it's clearly that if B only has name, A should be cleaned
+				current.first_xpos = m_zero;
+				current.first_ypos = m_zero;
+				current.second_xpos = m_zero;
+				current.second_ypos = m_zero;
+				current.left = 0;
+				current.right = 0;
+			}
+			else {
+				//  if B has name and name2, but A only has name, then clean the state
+				if (last.middle != 0) {
+					current.middle_xpos = m_zero;
+					current.middle_ypos = m_zero;
+					current.first_xpos = m_zero;
+					current.first_ypos = m_zero;
+					current.second_xpos = m_zero;
+					current.second_ypos = m_zero;
+				}
+
+				current.middle = 0;
+				current.left = m_assets.intern(name);
+				current.right = m_assets.intern(name2);
+			}
+		}
+		void readCharacterAction(const arksp::token_view& tok, const arksp::EnvData& last) {
+			auto type = valueOr(tok, arksp::PropKey::Type, "");
+			auto xpos = valueOr(tok, arksp::PropKey::Xpos, "");
+			auto ypos = valueOr(tok, arksp::PropKey::Ypos, "");
+			if (valueOr(tok, arksp::PropKey::Name, "") == "left") {
+				if (type == "exit") {
+					if (valueOr(tok, arksp::PropKey::Direction, "") == "left") {
+						current.first_xpos = literal("-4000");
+					}
+					else {
+						current.first_xpos = literal("4000");
+					}
+				}
+				else {
+					if (!xpos.empty()) {
+						current.first_xpos = computed(numberOf(literal(xpos)) + numberOf(last.first_xpos));
+					}
+					if (!ypos.empty()) {
+						current.first_ypos = computed(numberOf(literal(ypos)) + numberOf(last.first_ypos));
+					}
+				}
+			}
+			else {
+				if (type == "exit") {
+					if (valueOr(tok, arksp::PropKey::Direction, "") == "left") {
+						current.second_xpos = literal("-2000");
+					}
+					else {
+						current.second_xpos = literal("2000");
+					}
+				}
+				else {
+					if (!xpos.empty()) {
+						current.second_xpos = computed(numberOf(literal(xpos)) + numberOf(last.second_xpos));
+					}
+					if (!ypos.empty()) {
+						current.second_ypos = computed(numberOf(literal(ypos)) + numberOf(last.second_ypos));
+					}
+				}
+			}
+		}
+		void readImage(const arksp::token_view& tok) {
+			current.image = m_assets.intern(valueOr(tok, arksp::PropKey::Image, ""));
+			current.image_xScale = literal(valueOr(tok, arksp::PropKey::XScale, "0"));
+			current.image_yScale = literal(valueOr(tok, arksp::PropKey::YScale, "0"));
+			current.image_y = literal(valueOr(tok, arksp::PropKey::Y, "0"));
+			current.image_x = literal(valueOr(tok, arksp::PropKey::X, "0"));
+		}
+		void readImageTween(const arksp::token_view& tok) {
+			auto _yTo = valueOr(tok, arksp::PropKey::YTo, "");
+			auto _xTo = valueOr(tok, arksp::PropKey::XTo, "");
+			auto _xScale = valueOr(tok, arksp::PropKey::XScaleTo, "");
+			auto _yScale = valueOr(tok, arksp::PropKey::YScaleTo, "");
+			if (_yTo != "") {
+				current.image_y = computed(numberOf(literal(_yTo)) + numberOf(current.bg_y));
+			}
+			if (_xTo != "") {
+				current.image_x = computed(numberOf(literal(_xTo)) + numberOf(current.bg_x));
+			}
+			if (_xScale != "") {
+				current.image_xScale = literal(_xScale);
+			}
+			if (_yScale != "") {
+				current.image_yScale = literal(_yScale);
+			}
+		}
+
+		//  the value of the prop, or fallback if it's missing or empty
+		static inline std::string_view valueOr(const arksp::token_view& tok, const arksp::PropKey& keyId, std::string_view fallback) {
+			auto value = tok.valueOf(keyId);
+			return value && !value->empty() ? *value : fallback;
+		}
+
+		//  a number as it's written in a prop, each distinct one is parsed once
+		arksp::EnvNumber literal(std::string_view text) {
+			arksp::EnvNumber ret;
+			ret.text = m_assets.intern(text);
+			ret.value = m_assets.numeric(ret.text) ? m_assets.number(ret.text) : 0.0f;
+			return ret;
+		}
+		static inline arksp::EnvNumber computed(const float& value) {
+			arksp::EnvNumber ret;
+			ret.value = value;
+			return ret;
+		}
+		//  Throws std::invalid_argument for text that isn't a number, as std::stof() did.
+		//  A computed number used to be stored as std::to_string() and read back,
+		//  it's rounded to the same 6 decimals here without the round trip.
+		float numberOf(const arksp::EnvNumber& n) const {
+			if (n.text != 0) {
+				if (!m_assets.numeric(n.text)) {
+					throw std::invalid_argument("stof");
+				}
+				return n.value;
+			}
+			return static_cast<float>(std::nearbyint(static_cast<double>(n.value) * 1e6) / 1e6);
+		}
+
+		std::map<std::string, std::pair<Handler, bool>, std::less<>> m_mapHandler;  //  of setHandler(), with block; std::less<> finds a string_view without a copy
+		std::vector<arksp::prop_view> m_vecProp;  //  of the token slotRead() is reading
+		arksp::AssetTable m_assets;
+		arksp::EnvNumber m_zero;
+		std::unordered_map<arksp::EnvHistory::sizeType, EnvState> m_mapView;  //  of getContext()
+
 #ifndef ARKSP_DEBUG
-		std::vector<EnvState> m_env;		
+		arksp::EnvHistory m_env;
 #ifdef ARKSP_CONTEXT
 		std::vector<Context> m_ctx;
 #endif
 #endif
-		EnvState current{ {"middle",""},
-				{"left",""},
-				{"right",""},
-				{"background","default"},
-				{"bg_xscale","1"},
-				{"bg_yscale","1"},
-				{"bg_x","0"},
-				{"bg_y","0"},
-				{"image",""},
-				{"image_xScale","1"},
-				{"image_yScale","1"},
-				{"image_x","0"},
-				{"image_y","0"},
-				{"first_xpos","0"},
-				{"first_ypos","0"},
-				{"second_xpos","0"},
-				{"second_ypos","0"},
-				{"middle_xpos","0"},
-				{"middle_ypos","0"} };
+		arksp::EnvData current;
+	};
+
+	//  Scene state at any token of the script of a Manager, without reading
+	//  it from the start. index() reads every token into the Environment once
+	//  and saves a Snapshot every interval tokens, seek() restores the one
+	//  before and reads only the tokens in between. A shorter interval takes
+	//  more memory (sizeof(Environment::Snapshot) each) for a faster seek.
+	//  The states of the whole script are kept too, so seeking forward
+	//  doesn't read the tokens skipped over.
+	//  Call index() again after the tokens of the Manager change.
+	template<typename ManagerT>
+	class SceneSeeker {
+	public:
+		SceneSeeker(ManagerT& manager, arksp::Environment& env, const std::size_t& interval = 256)
+			: m_manager(manager), m_env(env), m_interval(std::max<std::size_t>(interval, 1)) {}
+
+		//  Starts from the state env is in now, and leaves env at the end of the script.
+		void index() {
+			m_vecSnapshot.clear();
+			const std::size_t n = m_manager.getSize();
+			m_vecSnapshot.reserve(n / m_interval + 1);
+			for (std::size_t i = 0; i < n; ++i) {
+				if (i % m_interval == 0) {
+					m_vecSnapshot.push_back(m_env.save());
+				}
+				read(i);
+			}
+			if (n % m_interval == 0) {
+				m_vecSnapshot.push_back(m_env.save());
+			}
+			m_size = n;
+			m_history = m_env.history();
+		}
+
+		//  Leaves env as if the tokens before index were read, and the pointer
+		//  of the Manager on index, so dispatching can go on from there.
+		//  index can be the size of the script for its end.
+		const arksp::EnvData& seek(const std::size_t& index) {
+			if (m_vecSnapshot.empty() || index > m_size) {
+				throw std::string("Error: Out of index");
+			}
+			const std::size_t first = index / m_interval;
+			m_env.restore(m_vecSnapshot[first], m_history);
+			for (std::size_t i = first * m_interval; i < index; ++i) {
+				read(i);
+			}
+			if (index < m_size) {
+				m_manager.ptrGoto(static_cast<unsigned int>(index));
+			}
+			return m_env.getCurrent();
+		}
+
+		std::size_t interval() const {
+			return m_interval;
+		}
+		std::size_t memory() const {
+			return m_vecSnapshot.capacity() * sizeof(arksp::Environment::Snapshot) + m_history.memory();
+		}
+
+	private:
+		void read(const std::size_t& index) {
+			m_manager.ptrGoto(static_cast<unsigned int>(index));
+			m_env.slotReadView(m_manager.getTokenView());
+		}
+
+		ManagerT& m_manager;
+		arksp::Environment& m_env;
+		std::size_t m_interval;
+		std::size_t m_size = 0;
+		std::vector<arksp::Environment::Snapshot> m_vecSnapshot;  //  before token i * m_interval
+		arksp::EnvHistory m_history;  //  of the whole script
 	};
-}
\ No newline at end of file
+}